@@ -0,0 +1,338 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+// Times each analysis stage in isolation, and the whole pipeline, on
+// deterministic synthetic audio. Throughput is reported in seconds of audio
+// processed per second of CPU time.
+//
+// usage: keyfinder-bench [seconds of audio per track, default 30]
+
+#include "keyfinder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <string>
+
+namespace {
+
+struct Timing {
+    double cpuSeconds = 0.0;
+    double wallSeconds = 0.0;
+};
+
+class Stopwatch {
+public:
+    Stopwatch()
+        : cpuStart_(std::clock())
+        , wallStart_(std::chrono::steady_clock::now())
+    {
+    }
+    [[nodiscard]] auto elapsed() const -> Timing
+    {
+        Timing t;
+        t.cpuSeconds = (double)(std::clock() - cpuStart_) / CLOCKS_PER_SEC;
+        t.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart_).count();
+        return t;
+    }
+
+private:
+    std::clock_t cpuStart_;
+    std::chrono::steady_clock::time_point wallStart_;
+};
+
+// Runs setup then body until body has used enough CPU time for a stable
+// figure, and returns the mean timing of one body call. Setup isn't timed.
+auto repeat(const std::function<void()>& setup, const std::function<void()>& body) -> Timing
+{
+    const unsigned int minimumRuns = 3;
+    const double minimumCpuSeconds = 0.5;
+    Timing total;
+    unsigned int runs = 0;
+    while (runs < minimumRuns || total.cpuSeconds < minimumCpuSeconds) {
+        setup();
+        Stopwatch sw;
+        body();
+        Timing t = sw.elapsed();
+        total.cpuSeconds += t.cpuSeconds;
+        total.wallSeconds += t.wallSeconds;
+        runs++;
+    }
+    total.cpuSeconds /= runs;
+    total.wallSeconds /= runs;
+    return total;
+}
+
+void report(const char* stage, unsigned int frameRate, double audioSeconds, const Timing& t)
+{
+    double cpuSeconds = std::max(t.cpuSeconds, 1e-9);
+    std::printf("%-32s %6u %14.1f %12.3f %12.3f\n", stage, frameRate, audioSeconds / cpuSeconds, t.cpuSeconds * 1000, t.wallSeconds * 1000);
+}
+
+// A slowly changing triad over a low drone, with a little noise, in stereo.
+auto syntheticTrack(unsigned int frameRate, double seconds) -> KeyFinder::AudioData
+{
+    KeyFinder::AudioData audio;
+    audio.setChannels(2);
+    audio.setFrameRate(frameRate);
+    auto frames = (unsigned int)(seconds * frameRate);
+    audio.addToFrameCount(frames);
+    float* samples = audio.getSampleData();
+    const double triad[3] = { 220.0, 261.63, 329.63 };
+    unsigned int noise = 12345;
+    for (unsigned int f = 0; f < frames; f++) {
+        double t = (double)f / frameRate;
+        double value = 0.2 * sin(2 * PI * 110.0 * t);
+        for (unsigned int n = 0; n < 3; n++) {
+            double wobble = 1.0 + 0.002 * sin(2 * PI * 0.25 * t);
+            value += 0.15 * sin(2 * PI * triad[n] * wobble * t);
+        }
+        noise = (noise * 1103515245) + 12345;
+        double hiss = (((noise >> 16) & 0x7FFF) / 32768.0 - 0.5) * 0.02;
+        samples[f * 2] = value + hiss;
+        samples[(f * 2) + 1] = value - hiss;
+    }
+    return audio;
+}
+
+// Mono chords drawn from I, vi, IV and V of the key (i, VI, iv and v for
+// minor keys) over the tonic drone, so that different parts of the track
+// suggest different keys. Chord order and lengths (0.8 to 3.2 s) are random,
+// seeded by the key, so the track has no period for strided sampling to
+// alias with.
+auto progressionTrack(unsigned int frameRate, double seconds, KeyFinder::KeyT key) -> KeyFinder::AudioData
+{
+    bool minor = key % 2 == 1;
+    double tonic = 110.0 * pow(2.0, (key / 2) / 12.0);
+    const int roots[4] = { 0, minor ? 8 : 9, 5, 7 };
+    const bool chordMinor[4] = { minor, !minor, minor, minor };
+
+    KeyFinder::AudioData audio;
+    audio.setChannels(1);
+    audio.setFrameRate(frameRate);
+    auto frames = (unsigned int)(seconds * frameRate);
+    audio.addToFrameCount(frames);
+    float* samples = audio.getSampleData();
+    unsigned int random = 2463534242U + key;
+    auto next = [&random]() {
+        random = (random * 1103515245) + 12345;
+        return ((random >> 16) & 0x7FFF) / 32768.0;
+    };
+    unsigned int chord = 0;
+    double chordEnd = 0.0;
+    for (unsigned int f = 0; f < frames; f++) {
+        double t = (double)f / frameRate;
+        if (t >= chordEnd) {
+            chord = (unsigned int)(next() * 4) % 4;
+            chordEnd = t + 0.8 + (2.4 * next());
+        }
+        double root = tonic * 2 * pow(2.0, roots[chord] / 12.0);
+        double value = 0.2 * sin(2 * PI * tonic * t);
+        value += 0.15 * sin(2 * PI * root * t);
+        value += 0.15 * sin(2 * PI * root * pow(2.0, (chordMinor[chord] ? 3 : 4) / 12.0) * t);
+        value += 0.15 * sin(2 * PI * root * pow(2.0, 7 / 12.0) * t);
+        samples[f] = value;
+    }
+    return audio;
+}
+
+// Quick scans of one track in every key, against full analysis: the CPU
+// time, and how often the quick scan agrees with the full analysis and with
+// the key the track was written in. Sampling is meant for whole songs, so the
+// tracks are at least three minutes long.
+void benchmarkQuickScan(double seconds)
+{
+    const unsigned int frameRate = 44100;
+    seconds = std::max(seconds, 180.0);
+    std::vector<KeyFinder::AudioData> tracks;
+    for (unsigned int k = 0; k < KEYS; k++) {
+        tracks.push_back(progressionTrack(frameRate, seconds, (KeyFinder::KeyT)k));
+    }
+
+    KeyFinder::KeyFinder kf;
+    std::vector<KeyFinder::KeyT> fullKeys(KEYS);
+    Stopwatch fullWatch;
+    for (unsigned int k = 0; k < KEYS; k++) {
+        fullKeys[k] = kf.keyOfAudio(tracks[k]);
+    }
+    double fullCpuSeconds = std::max(fullWatch.elapsed().cpuSeconds, 1e-9);
+
+    std::printf("\n%-32s %10s %10s %12s %12s\n", "quick scan (44100 Hz)", "hops", "speedup", "= full", "= written");
+    auto scan = [&](const char* name, const KeyFinder::QuickScanOptions& options) {
+        unsigned int agreeFull = 0;
+        unsigned int agreeWritten = 0;
+        unsigned int hops = 0;
+        unsigned int hopsTotal = 0;
+        Stopwatch watch;
+        for (unsigned int k = 0; k < KEYS; k++) {
+            KeyFinder::QuickScanResult r = kf.keyOfAudioQuickScan(tracks[k], options);
+            agreeFull += r.key == fullKeys[k] ? 1 : 0;
+            agreeWritten += r.key == (KeyFinder::KeyT)k ? 1 : 0;
+            hops += r.hopsAnalysed;
+            hopsTotal += r.hopsTotal;
+        }
+        double cpuSeconds = std::max(watch.elapsed().cpuSeconds, 1e-9);
+        std::printf("%-32s %5u/%-4u %9.1fx %11.0f%% %11.0f%%\n", name, hops / KEYS, hopsTotal / KEYS, fullCpuSeconds / cpuSeconds,
+            100.0 * agreeFull / KEYS, 100.0 * agreeWritten / KEYS);
+    };
+    unsigned int fullWritten = 0;
+    for (unsigned int k = 0; k < KEYS; k++) {
+        fullWritten += fullKeys[k] == (KeyFinder::KeyT)k ? 1 : 0;
+    }
+    std::printf("%-32s %10s %9.1fx %11.0f%% %11.0f%%\n", "full analysis", "all", 1.0, 100.0, 100.0 * fullWritten / KEYS);
+
+    KeyFinder::QuickScanOptions options;
+    for (unsigned int stride : { 2U, 4U, 8U, 16U, 32U }) {
+        options.hopStride = stride;
+        std::string name = "every " + std::to_string(stride) + " hops";
+        scan(name.c_str(), options);
+    }
+    options.hopBudget = 8;
+    scan("budget of 8 hops", options);
+}
+
+void benchmarkRate(unsigned int frameRate, double seconds)
+{
+    const KeyFinder::AudioData track = syntheticTrack(frameRate, seconds);
+
+    // the same parameters the pipeline derives in KeyFinder::preprocess
+    float lpfCutoff = KeyFinder::getLastFrequency() * 1.012;
+    float dsCutoff = KeyFinder::getLastFrequency() * 1.10;
+    auto downsampleFactor = (unsigned int)floor(frameRate / 2 / dsCutoff);
+    unsigned int analysisRate = frameRate / downsampleFactor;
+    double hopSeconds = (double)HOPSIZE / analysisRate;
+
+    KeyFinder::LowPassFilterFactory lpfFactory;
+    KeyFinder::ChromaTransformFactory ctFactory;
+    const KeyFinder::LowPassFilter* lpf = lpfFactory.getLowPassFilter(160, frameRate, lpfCutoff, 2048);
+    const KeyFinder::ChromaTransform* ct = ctFactory.getChromaTransform(analysisRate);
+
+    KeyFinder::AudioData working;
+    auto copyTrack = [&]() { working = track; };
+    KeyFinder::AudioData mono = track;
+    mono.reduceToMono();
+    auto copyMono = [&]() { working = mono; };
+    KeyFinder::Workspace workspace;
+
+    report("AudioData::reduceToMono", frameRate, seconds, repeat(copyTrack, [&]() { working.reduceToMono(); }));
+    report("LowPassFilter::filter", frameRate, seconds, repeat(copyMono, [&]() { lpf->filter(working, workspace, downsampleFactor); }));
+    report("AudioData::downsample", frameRate, seconds, repeat(copyMono, [&]() { working.downsample(downsampleFactor); }));
+    report("LowPassFilter::decimate", frameRate, seconds, repeat(copyMono, [&]() { lpf->decimate(working, workspace, downsampleFactor); }));
+    // both front ends from stereo, as in KeyFinder::preprocess. The resampler's
+    // filter keeps its transition band in Hz, so its taps grow with the rate.
+    KeyFinder::AudioView trackView(track.getSampleData(), track.getFrameCount(), track.getChannels(), frameRate);
+    report("LowPassFilter::decimate (stereo)", frameRate, seconds, repeat([&]() { working.clear(); }, [&]() { lpf->decimate(trackView, working, workspace, downsampleFactor, true); }));
+    KeyFinder::Resampler resampler(frameRate, 4410, lpfCutoff);
+    report("Resampler::resample", frameRate, seconds, repeat([&]() { working.clear(); }, [&]() { resampler.resample(trackView, working, workspace, true); }));
+    std::printf("  taps per output: %u decimating, %u resampling\n", 161U, resampler.getTapsPerPhase());
+
+    // per-hop stages run a fixed number of hops, filled with real analysis-rate audio
+    const unsigned int hops = 64;
+    KeyFinder::AudioData analysisAudio = mono;
+    lpf->decimate(analysisAudio, workspace, downsampleFactor);
+    KeyFinder::FftAdapter fft(FFTFRAMESIZE);
+    for (unsigned int i = 0; i < FFTFRAMESIZE && i < analysisAudio.getSampleCount(); i++) {
+        fft.setInput(i, analysisAudio.getSample(i));
+    }
+    report("FftAdapter::execute", frameRate, hops * hopSeconds, repeat([]() {}, [&]() {
+        for (unsigned int h = 0; h < hops; h++) {
+            fft.execute();
+        }
+    }));
+    float chroma[BANDS];
+    report("ChromaTransform::chromaVector", frameRate, hops * hopSeconds, repeat([]() {}, [&]() {
+        for (unsigned int h = 0; h < hops; h++) {
+            ct->chromaVector(&fft, 0, chroma);
+        }
+    }));
+
+    // one classification covers a whole track in keyOfAudio
+    KeyFinder::KeyClassifier classifier(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+    std::vector<float> chromaVector(chroma, chroma + BANDS);
+    volatile KeyFinder::KeyT sink = KeyFinder::SILENCE;
+    report("KeyClassifier::classify", frameRate, seconds, repeat([]() {}, [&]() { sink = classifier.classify(chromaVector); }));
+
+    KeyFinder::KeyFinder kf;
+    report("KeyFinder::keyOfAudio", frameRate, seconds, repeat([]() {}, [&]() { sink = kf.keyOfAudio(track); }));
+    report("KeyFinder::keyOfAudio (threads)", frameRate, seconds, repeat([]() {}, [&]() { sink = kf.keyOfAudio(track, 0); }));
+    report("KeyFinder::keyOfAudioQuickScan", frameRate, seconds, repeat([]() {}, [&]() { sink = kf.keyOfAudioQuickScan(track).key; }));
+    KeyFinder::AnalysisConfig canonical;
+    canonical.analysisRate = 4410;
+    KeyFinder::KeyFinder resampling(canonical);
+    report("KeyFinder::keyOfAudio (4410 Hz)", frameRate, seconds, repeat([]() {}, [&]() { sink = resampling.keyOfAudio(track); }));
+
+    // progressive analysis of decoder-sized packets, classifying as it goes
+    const unsigned int packetFrames = 4096;
+    report("KeyFinder progressive", frameRate, seconds, repeat([]() {}, [&]() {
+        KeyFinder::Workspace w;
+        const float* samples = track.getSampleData();
+        for (unsigned int f = 0; f < track.getFrameCount(); f += packetFrames) {
+            unsigned int frames = std::min(packetFrames, track.getFrameCount() - f);
+            kf.progressiveChromagram(KeyFinder::AudioView(samples + (f * 2), frames, 2, frameRate), w);
+            if (w.chromagram != nullptr) {
+                sink = KeyFinder::KeyFinder::keyOfChromagram(w);
+            }
+        }
+        kf.finalChromagram(w);
+        sink = KeyFinder::KeyFinder::keyOfChromagram(w);
+    }));
+
+    // where the time goes inside a whole-track analysis
+    KeyFinder::AnalysisStats stats;
+    KeyFinder::Workspace w;
+    w.stats = &stats;
+    kf.progressiveChromagram(track, w);
+    kf.finalChromagram(w);
+    sink = KeyFinder::KeyFinder::keyOfChromagram(w);
+    for (auto stage : { KeyFinder::STAGE_PREPROCESS, KeyFinder::STAGE_WINDOWING, KeyFinder::STAGE_FFT, KeyFinder::STAGE_CHROMA, KeyFinder::STAGE_CLASSIFICATION }) {
+        KeyFinder::AnalysisStats::Stage s = stats.getStage(stage);
+        Timing t;
+        t.cpuSeconds = s.cpuSeconds;
+        t.wallSeconds = s.wallSeconds;
+        std::string name = std::string("  stage: ") + KeyFinder::AnalysisStats::getStageName(stage);
+        report(name.c_str(), frameRate, seconds, t);
+    }
+    (void)sink;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = 30.0;
+    if (argc > 1) {
+        seconds = std::atof(argv[1]);
+    }
+    if (argc > 2 || seconds <= 0) {
+        std::fprintf(stderr, "usage: %s [seconds of audio per track]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%-32s %6s %14s %12s %12s\n", "stage", "rate", "audio-s/cpu-s", "cpu ms/run", "wall ms/run");
+    for (unsigned int frameRate : { 44100U, 48000U, 96000U }) {
+        benchmarkRate(frameRate, seconds);
+    }
+    benchmarkQuickScan(seconds);
+    return 0;
+}
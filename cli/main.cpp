@@ -0,0 +1,299 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+// Estimates the key of every WAV file given on the command line, searching
+// directories recursively. Files are memory-mapped and fed to the progressive
+// API a bounded chunk at a time. Only running chroma totals are kept and pages
+// already read are released, so memory use doesn't grow with track length;
+// several files are analysed at once, longest first.
+//
+// usage: keyfinder-cli [-j workers] [--format json|csv] [--chunk frames] path...
+
+#include "keyfinder.h"
+#include "mappedfile.h"
+#include "wavfile.h"
+#include "workspacepool.h"
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const unsigned int DEFAULT_CHUNK_FRAMES = 65536;
+
+struct Options {
+    unsigned int workers = 0;
+    unsigned int chunkFrames = DEFAULT_CHUNK_FRAMES;
+    bool csv = false;
+    std::vector<std::string> paths;
+};
+
+struct Result {
+    std::string path;
+    unsigned long long size = 0;
+    KeyFinder::KeyT key = KeyFinder::SILENCE;
+    double seconds = 0.0;
+    std::string error;
+};
+
+auto keyName(KeyFinder::KeyT key) -> const char*
+{
+    static const char* const names[] = {
+        "A major", "A minor", "Bb major", "Bb minor", "B major", "B minor",
+        "C major", "C minor", "Db major", "Db minor", "D major", "D minor",
+        "Eb major", "Eb minor", "E major", "E minor", "F major", "F minor",
+        "Gb major", "Gb minor", "G major", "G minor", "Ab major", "Ab minor",
+        "silence"
+    };
+    return names[key];
+}
+
+void usage()
+{
+    fprintf(stderr, "usage: keyfinder-cli [-j workers] [--format json|csv] [--chunk frames] path...\n");
+}
+
+auto parseCount(const char* text, unsigned int& value) -> bool
+{
+    char* end = nullptr;
+    unsigned long parsed = strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || parsed > 0xFFFFFFFFUL) {
+        return false;
+    }
+    value = (unsigned int)parsed;
+    return true;
+}
+
+auto parseOptions(int argc, char** argv, Options& options) -> bool
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "-j" || arg == "--jobs") && hasValue) {
+            if (!parseCount(argv[++i], options.workers)) {
+                return false;
+            }
+        } else if (arg == "--chunk" && hasValue) {
+            if (!parseCount(argv[++i], options.chunkFrames) || options.chunkFrames == 0) {
+                return false;
+            }
+        } else if (arg == "--format" && hasValue) {
+            std::string format = argv[++i];
+            if (format != "json" && format != "csv") {
+                return false;
+            }
+            options.csv = format == "csv";
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+    return !options.paths.empty();
+}
+
+auto isWavPath(const fs::path& path) -> bool
+{
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return extension == ".wav" || extension == ".wave" || extension == ".rf64";
+}
+
+// Files named directly are taken whatever their extension; directories are
+// searched for WAV files. Each group is sorted so output order is stable.
+auto collectFiles(const std::vector<std::string>& paths) -> std::vector<Result>
+{
+    std::vector<Result> files;
+    for (const std::string& path : paths) {
+        std::error_code error;
+        if (fs::is_directory(path, error)) {
+            std::vector<Result> found;
+            for (fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, error), end; it != end; it.increment(error)) {
+                if (error) {
+                    break;
+                }
+                if (it->is_regular_file(error) && isWavPath(it->path())) {
+                    Result r;
+                    r.path = it->path().string();
+                    r.size = it->file_size(error);
+                    found.push_back(r);
+                }
+            }
+            std::sort(found.begin(), found.end(), [](const Result& a, const Result& b) { return a.path < b.path; });
+            files.insert(files.end(), found.begin(), found.end());
+        } else {
+            Result r;
+            r.path = path;
+            r.size = fs::file_size(path, error);
+            files.push_back(r);
+        }
+    }
+    return files;
+}
+
+void analyse(KeyFinder::KeyFinder& keyFinder, KeyFinder::WorkspacePool& pool, unsigned int chunkFrames, Result& result)
+{
+    KeyFinder::Workspace* workspace = pool.acquire();
+    try {
+        MappedFile file(result.path);
+        WavFile wav(file.getData(), file.getSize());
+        const unsigned char* samples = wav.getSamples();
+        uint64_t remaining = wav.getFrameCount();
+        // only the key is wanted, so no hops need keeping
+        workspace->retainRecentHops(0);
+        while (remaining > 0) {
+            unsigned int frames = (unsigned int)std::min<uint64_t>(remaining, chunkFrames);
+            KeyFinder::AudioView chunk(samples, frames, wav.getChannels(), wav.getFrameRate(), wav.getSampleFormat());
+            keyFinder.progressiveChromagram(chunk, *workspace);
+            samples += (size_t)frames * wav.getFrameSize();
+            remaining -= frames;
+            file.release(samples - file.getData());
+        }
+        keyFinder.finalChromagram(*workspace);
+        result.key = KeyFinder::KeyFinder::keyOfChromagram(*workspace);
+        result.seconds = (double)wav.getFrameCount() / wav.getFrameRate();
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    pool.release(workspace);
+}
+
+void printJsonString(const std::string& text)
+{
+    putchar('"');
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            printf("\\%c", c);
+        } else if (c < 0x20) {
+            printf("\\u%04x", c);
+        } else {
+            putchar(c);
+        }
+    }
+    putchar('"');
+}
+
+void printCsvField(const std::string& text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos) {
+        fputs(text.c_str(), stdout);
+        return;
+    }
+    putchar('"');
+    for (char c : text) {
+        if (c == '"') {
+            putchar('"');
+        }
+        putchar(c);
+    }
+    putchar('"');
+}
+
+void printJson(const std::vector<Result>& results)
+{
+    printf("[");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        printf(i == 0 ? "\n  {\"path\": " : ",\n  {\"path\": ");
+        printJsonString(r.path);
+        if (r.error.empty()) {
+            printf(", \"key\": \"%s\", \"seconds\": %.3f}", keyName(r.key), r.seconds);
+        } else {
+            printf(", \"error\": ");
+            printJsonString(r.error);
+            printf("}");
+        }
+    }
+    printf(results.empty() ? "]\n" : "\n]\n");
+}
+
+void printCsv(const std::vector<Result>& results)
+{
+    printf("path,key,seconds,error\n");
+    for (const Result& r : results) {
+        printCsvField(r.path);
+        if (r.error.empty()) {
+            printf(",%s,%.3f,\n", keyName(r.key), r.seconds);
+        } else {
+            printf(",,,");
+            printCsvField(r.error);
+            printf("\n");
+        }
+    }
+}
+
+}
+
+auto main(int argc, char** argv) -> int
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+    unsigned int workers = options.workers;
+    if (workers == 0) {
+        workers = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    std::vector<Result> results = collectFiles(options.paths);
+    // bigger files take longer, so they're dealt out first
+    std::vector<unsigned long long> costs;
+    costs.reserve(results.size());
+    for (const Result& r : results) {
+        costs.push_back(r.size);
+    }
+
+    KeyFinder::KeyFinder keyFinder;
+    KeyFinder::WorkspacePool pool;
+    auto start = std::chrono::steady_clock::now();
+    KeyFinder::WorkStealingPool::run(costs, workers, [&](unsigned int i) {
+        analyse(keyFinder, pool, options.chunkFrames, results[i]);
+    });
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (options.csv) {
+        printCsv(results);
+    } else {
+        printJson(results);
+    }
+
+    unsigned int failures = 0;
+    double audioSeconds = 0.0;
+    for (const Result& r : results) {
+        failures += r.error.empty() ? 0 : 1;
+        audioSeconds += r.seconds;
+    }
+    fprintf(stderr, "%zu files (%u failed), %.1f s of audio in %.2f s on %u workers\n",
+        results.size(), failures, audioSeconds, wallSeconds, workers);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,144 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "mappedfile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& path)
+{
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        throw std::runtime_error("cannot open file");
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file_, &size) == 0) {
+        CloseHandle(file_);
+        throw std::runtime_error("cannot read file size");
+    }
+    size_ = (size_t)size.QuadPart;
+    if (size_ == 0) {
+        return;
+    }
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ != nullptr) {
+        data_ = (const unsigned char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (data_ == nullptr) {
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+        }
+        CloseHandle(file_);
+        throw std::runtime_error("cannot map file");
+    }
+}
+
+void MappedFile::release(size_t /*end*/)
+{
+    // clean pages of a read-only view leave the working set under pressure
+    // anyway, and there's no cheap way to drop a range of one
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr) {
+        CloseHandle(file_);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open file");
+    }
+    struct stat st {
+    };
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot read file size");
+    }
+    size_ = (size_t)st.st_size;
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("cannot map file");
+        }
+        data_ = (const unsigned char*)data;
+        madvise(data, size_, MADV_SEQUENTIAL);
+    }
+    // the mapping stays valid without the descriptor
+    close(fd);
+}
+
+void MappedFile::release(size_t end)
+{
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    end = std::min(end, size_) / pageSize * pageSize;
+    if (data_ == nullptr || end <= released_) {
+        return;
+    }
+    // the mapping is read-only, so dropped pages are simply read again if needed
+    madvise((void*)(data_ + released_), end - released_, MADV_DONTNEED);
+    released_ = end;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr) {
+        munmap((void*)data_, size_);
+    }
+}
+
+#endif
+
+auto MappedFile::getData() const -> const unsigned char*
+{
+    return data_;
+}
+
+auto MappedFile::getSize() const -> size_t
+{
+    return size_;
+}
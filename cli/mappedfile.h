@@ -0,0 +1,53 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory map of a whole file, hinted for one sequential pass.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+    [[nodiscard]] auto getData() const -> const unsigned char*;
+    [[nodiscard]] auto getSize() const -> size_t;
+    // Lets the system drop the pages before end, which a sequential reader
+    // has finished with, so resident memory stays bounded on long files.
+    void release(size_t end);
+
+private:
+    const unsigned char* data_ { nullptr };
+    size_t size_ { 0 };
+    size_t released_ { 0 };
+#if defined(_WIN32)
+    void* file_ { nullptr };
+    void* mapping_ { nullptr };
+#endif
+};
+
+#endif
@@ -0,0 +1,171 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "wavfile.h"
+
+#include <cstring>
+#include <stdexcept>
+
+static const uint16_t WAVE_FORMAT_PCM = 0x0001;
+static const uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+static const uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// RIFF fields are little-endian whatever the host
+static auto read16(const unsigned char* p) -> uint16_t
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static auto read32(const unsigned char* p) -> uint32_t
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static auto read64(const unsigned char* p) -> uint64_t
+{
+    return (uint64_t)read32(p) | ((uint64_t)read32(p + 4) << 32);
+}
+
+static auto isTag(const unsigned char* p, const char* tag) -> bool
+{
+    return memcmp(p, tag, 4) == 0;
+}
+
+WavFile::WavFile(const unsigned char* data, size_t size)
+{
+    if (size < 12 || !isTag(data + 8, "WAVE") || !(isTag(data, "RIFF") || isTag(data, "RF64"))) {
+        throw std::runtime_error("not a WAV file");
+    }
+    bool rf64 = isTag(data, "RF64");
+
+    uint64_t rf64DataSize = 0;
+    uint16_t formatTag = 0;
+    unsigned int bitsPerSample = 0;
+    const unsigned char* dataChunk = nullptr;
+    uint64_t dataSize = 0;
+
+    size_t position = 12;
+    // the fmt chunk usually comes first, but may follow the data
+    while (position + 8 <= size && (dataChunk == nullptr || formatTag == 0)) {
+        const unsigned char* chunk = data + position;
+        uint64_t chunkSize = read32(chunk + 4);
+        const unsigned char* body = chunk + 8;
+        size_t available = size - position - 8;
+
+        if (isTag(chunk, "ds64")) {
+            if (chunkSize < 24 || available < 24) {
+                throw std::runtime_error("truncated ds64 chunk");
+            }
+            rf64DataSize = read64(body + 8);
+        } else if (isTag(chunk, "fmt ")) {
+            if (chunkSize < 16 || available < 16) {
+                throw std::runtime_error("truncated fmt chunk");
+            }
+            formatTag = read16(body);
+            channels_ = read16(body + 2);
+            frameRate_ = read32(body + 4);
+            frameSize_ = read16(body + 12);
+            bitsPerSample = read16(body + 14);
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE) {
+                if (chunkSize < 40 || available < 40) {
+                    throw std::runtime_error("truncated extensible fmt chunk");
+                }
+                // the sub-format GUID starts with the plain format tag
+                formatTag = read16(body + 24);
+            }
+        } else if (isTag(chunk, "data")) {
+            dataChunk = body;
+            dataSize = (rf64 && chunkSize == 0xFFFFFFFF) ? rf64DataSize : chunkSize;
+            // tolerate files whose writer never patched the sizes
+            if (dataSize > available) {
+                dataSize = available;
+            }
+            chunkSize = dataSize;
+        }
+        if (chunkSize >= available) {
+            break;
+        }
+        // chunks are padded to an even length
+        position += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if (formatTag == 0) {
+        throw std::runtime_error("no fmt chunk");
+    }
+    if (dataChunk == nullptr) {
+        throw std::runtime_error("no data chunk");
+    }
+    if (channels_ == 0 || frameRate_ == 0) {
+        throw std::runtime_error("invalid fmt chunk");
+    }
+
+    if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 8) {
+        format_ = KeyFinder::SAMPLE_FORMAT_UINT8;
+    } else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 16) {
+        format_ = KeyFinder::SAMPLE_FORMAT_INT16;
+    } else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 24) {
+        format_ = KeyFinder::SAMPLE_FORMAT_INT24;
+    } else if (formatTag == WAVE_FORMAT_PCM && bitsPerSample == 32) {
+        format_ = KeyFinder::SAMPLE_FORMAT_INT32;
+    } else if (formatTag == WAVE_FORMAT_IEEE_FLOAT && bitsPerSample == 32) {
+        format_ = KeyFinder::SAMPLE_FORMAT_FLOAT32;
+    } else if (formatTag == WAVE_FORMAT_IEEE_FLOAT && bitsPerSample == 64) {
+        format_ = KeyFinder::SAMPLE_FORMAT_FLOAT64;
+    } else {
+        throw std::runtime_error("unsupported sample format");
+    }
+    if (frameSize_ != channels_ * (bitsPerSample / 8)) {
+        throw std::runtime_error("unsupported sample packing");
+    }
+
+    samples_ = dataChunk;
+    frameCount_ = dataSize / frameSize_;
+}
+
+auto WavFile::getSamples() const -> const unsigned char*
+{
+    return samples_;
+}
+
+auto WavFile::getFrameCount() const -> uint64_t
+{
+    return frameCount_;
+}
+
+auto WavFile::getChannels() const -> unsigned int
+{
+    return channels_;
+}
+
+auto WavFile::getFrameRate() const -> unsigned int
+{
+    return frameRate_;
+}
+
+auto WavFile::getSampleFormat() const -> KeyFinder::SampleFormatT
+{
+    return format_;
+}
+
+auto WavFile::getFrameSize() const -> unsigned int
+{
+    return frameSize_;
+}
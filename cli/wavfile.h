@@ -0,0 +1,52 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include "constants.h"
+
+#include <cstdint>
+
+// The sample data of a RIFF/WAVE or RF64 file held in memory. Handles PCM,
+// IEEE float and WAVE_FORMAT_EXTENSIBLE headers wrapping either.
+class WavFile {
+public:
+    // Throws std::runtime_error if the data isn't a supported WAV file.
+    WavFile(const unsigned char* data, size_t size);
+
+    [[nodiscard]] auto getSamples() const -> const unsigned char*;
+    [[nodiscard]] auto getFrameCount() const -> uint64_t;
+    [[nodiscard]] auto getChannels() const -> unsigned int;
+    [[nodiscard]] auto getFrameRate() const -> unsigned int;
+    [[nodiscard]] auto getSampleFormat() const -> KeyFinder::SampleFormatT;
+    [[nodiscard]] auto getFrameSize() const -> unsigned int;
+
+private:
+    const unsigned char* samples_ { nullptr };
+    uint64_t frameCount_ { 0 };
+    unsigned int channels_ { 0 };
+    unsigned int frameRate_ { 0 };
+    unsigned int frameSize_ { 0 };
+    KeyFinder::SampleFormatT format_ { KeyFinder::SAMPLE_FORMAT_INT16 };
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "analysisstats.h"
+
+#include <chrono>
+#include <ctime>
+
+namespace KeyFinder {
+
+static auto wallClock() -> double
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CPU time of the calling thread where the platform offers it, so that
+// threads recording concurrently don't count each other's work.
+static auto cpuClock() -> double
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+#else
+    return (double)std::clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+void AnalysisStats::record(AnalysisStageT stage, double wallSeconds, double cpuSeconds, unsigned long long items)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stage& s = stages_[stage];
+    s.wallSeconds += wallSeconds;
+    s.cpuSeconds += cpuSeconds;
+    s.calls++;
+    s.items += items;
+}
+
+auto AnalysisStats::getStage(AnalysisStageT stage) const -> Stage
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stages_[stage];
+}
+
+void AnalysisStats::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stage : stages_) {
+        stage = Stage();
+    }
+}
+
+auto AnalysisStats::getStageName(AnalysisStageT stage) -> const char*
+{
+    switch (stage) {
+    case STAGE_PREPROCESS:
+        return "preprocess";
+    case STAGE_WINDOWING:
+        return "windowing";
+    case STAGE_FFT:
+        return "fft";
+    case STAGE_CHROMA:
+        return "chroma";
+    case STAGE_CLASSIFICATION:
+        return "classification";
+    }
+    return "unknown";
+}
+
+StageTimer::StageTimer(AnalysisStats* stats, AnalysisStageT stage, unsigned long long items)
+    : stats_(stats)
+    , stage_(stage)
+    , items_(items)
+{
+    if (stats_ != nullptr) {
+        wallStart_ = wallClock();
+        cpuStart_ = cpuClock();
+    }
+}
+
+StageTimer::~StageTimer()
+{
+    if (stats_ != nullptr) {
+        stats_->record(stage_, wallClock() - wallStart_, cpuClock() - cpuStart_, items_);
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef ANALYSISSTATS_H
+#define ANALYSISSTATS_H
+
+#include "constants.h"
+
+namespace KeyFinder {
+
+// Accumulates time and work per analysis stage. Attach one to a Workspace to
+// have KeyFinder record into it; recording is thread safe, so a single object
+// can also collect from the threaded whole-track analysis.
+class AnalysisStats {
+public:
+    struct Stage {
+        double wallSeconds { 0.0 };
+        double cpuSeconds { 0.0 };
+        unsigned long long calls { 0 };
+        // frames for preprocessing, hops for the spectral stages and chroma
+        // vectors for classification
+        unsigned long long items { 0 };
+    };
+
+    void record(AnalysisStageT stage, double wallSeconds, double cpuSeconds, unsigned long long items);
+    [[nodiscard]] auto getStage(AnalysisStageT stage) const -> Stage;
+    void clear();
+    [[nodiscard]] static auto getStageName(AnalysisStageT stage) -> const char*;
+
+private:
+    mutable std::mutex mutex_;
+    Stage stages_[STAGE_CLASSIFICATION + 1];
+};
+
+// Times its own lifetime into a stage; does nothing if stats is null.
+class StageTimer {
+public:
+    StageTimer(AnalysisStats* stats, AnalysisStageT stage, unsigned long long items = 0);
+    ~StageTimer();
+    StageTimer(const StageTimer&) = delete;
+    auto operator=(const StageTimer&) -> StageTimer& = delete;
+
+private:
+    AnalysisStats* stats_;
+    AnalysisStageT stage_;
+    unsigned long long items_;
+    double wallStart_ { 0.0 };
+    double cpuStart_ { 0.0 };
+};
+
+}
+
+#endif
@@ -21,6 +21,8 @@
 
 #include "audiodata.h"
 
+#include <algorithm>
+
 namespace KeyFinder {
 
 AudioData::AudioData()
@@ -67,7 +69,7 @@ void AudioData::append(const AudioData& that)
     if (that.frameRate_ != frameRate_) {
         throw Exception("Cannot append audio data with a different frame rate");
     }
-    samples_.insert(samples_.end(), that.samples_.begin(), that.samples_.end());
+    samples_.insert(samples_.end(), that.getSampleData(), that.getSampleData() + that.getSampleCount());
 }
 
 void AudioData::prepend(const AudioData& that)
@@ -82,7 +84,14 @@ void AudioData::prepend(const AudioData& that)
     if (that.frameRate_ != frameRate_) {
         throw Exception("Cannot prepend audio data with a different frame rate");
     }
-    samples_.insert(samples_.begin(), that.samples_.begin(), that.samples_.end());
+    unsigned int prependSampleCount = that.getSampleCount();
+    if (front_ >= prependSampleCount) {
+        // reuse the space left behind by earlier discards
+        front_ -= prependSampleCount;
+        std::copy(that.getSampleData(), that.getSampleData() + prependSampleCount, samples_.begin() + front_);
+    } else {
+        samples_.insert(samples_.begin() + front_, that.getSampleData(), that.getSampleData() + prependSampleCount);
+    }
 }
 
 // get sample by absolute index
@@ -93,7 +102,7 @@ auto AudioData::getSample(unsigned int index) const -> float
         ss << "Cannot get out-of-bounds sample (" << index << "/" << getSampleCount() << ")";
         throw Exception(ss.str().c_str());
     }
-    return samples_[index];
+    return samples_[front_ + index];
 }
 
 // get sample by frame and channel
@@ -123,7 +132,7 @@ void AudioData::setSample(unsigned int index, float value)
     if (!std::isfinite(value)) {
         throw Exception("Cannot set sample to NaN");
     }
-    samples_[index] = value;
+    samples_[front_ + index] = value;
 }
 
 // set sample by frame and channel
@@ -144,7 +153,7 @@ void AudioData::setSampleByFrame(unsigned int frame, unsigned int channel, float
 
 void AudioData::addToSampleCount(unsigned int inSamples)
 {
-    samples_.resize(getSampleCount() + inSamples, 0.0);
+    samples_.resize(samples_.size() + inSamples, 0.0);
 }
 
 void AudioData::addToFrameCount(unsigned int inFrames)
@@ -157,7 +166,7 @@ void AudioData::addToFrameCount(unsigned int inFrames)
 
 auto AudioData::getSampleCount() const -> unsigned int
 {
-    return samples_.size();
+    return samples_.size() - front_;
 }
 
 auto AudioData::getFrameCount() const -> unsigned int
@@ -168,23 +177,33 @@ auto AudioData::getFrameCount() const -> unsigned int
     return getSampleCount() / channels_;
 }
 
+auto AudioData::getSampleData() const -> const float*
+{
+    return samples_.data() + front_;
+}
+
+auto AudioData::getSampleData() -> float*
+{
+    return samples_.data() + front_;
+}
+
 void AudioData::reduceToMono()
 {
     if (channels_ < 2) {
         return;
     }
-    auto readAt = samples_.begin();
-    auto writeAt = samples_.begin();
-    while (readAt < samples_.end()) {
+    unsigned int frameCount = getFrameCount();
+    const float* readAt = getSampleData();
+    float* writeAt = getSampleData();
+    for (unsigned int frame = 0; frame < frameCount; frame++) {
         float sum = 0.0;
         for (unsigned int c = 0; c < channels_; c++) {
-            sum += *readAt;
-            std::advance(readAt, 1);
+            sum += readAt[c];
         }
-        *writeAt = sum / channels_;
-        std::advance(writeAt, 1);
+        writeAt[frame] = sum / channels_;
+        readAt += channels_;
     }
-    samples_.resize(getSampleCount() / channels_);
+    samples_.resize(front_ + frameCount);
     channels_ = 1;
 }
 
@@ -197,36 +216,27 @@ void AudioData::downsample(unsigned int factor, bool shortcut)
     if (channels_ > 1) {
         throw Exception("Apply to monophonic only");
     }
-    auto readAt = samples_.begin();
-    auto writeAt = samples_.begin();
-
-    // Prevent std::advance out of iterator range problems
-    size_t numSamplesRemaining = samples_.size();
+    unsigned int sampleCount = getSampleCount();
+    unsigned int newSampleCount = ceil((float)sampleCount / (float)factor);
+    const float* readAt = getSampleData();
+    float* writeAt = getSampleData();
 
-    while (readAt < samples_.end()) {
+    for (unsigned int s = 0; s < newSampleCount; s++) {
+        unsigned int first = s * factor;
         float mean = 0.0;
         if (shortcut) {
-            mean = *readAt;
-            if (numSamplesRemaining >= factor) {
-                std::advance(readAt, factor);
-            } else {
-                readAt = samples_.end();
-            }
-            numSamplesRemaining -= factor;
+            mean = readAt[first];
         } else {
-            for (unsigned int s = 0; s < factor; s++) {
-                if (readAt < samples_.end()) {
-                    mean += *readAt;
-                    std::advance(readAt, 1);
-                    --numSamplesRemaining;
+            for (unsigned int i = first; i < first + factor; i++) {
+                if (i < sampleCount) {
+                    mean += readAt[i];
                 }
                 mean /= (float)factor;
             }
         }
-        *writeAt = mean;
-        std::advance(writeAt, 1);
+        writeAt[s] = mean;
     }
-    samples_.resize(ceil((float)getSampleCount() / (float)factor));
+    samples_.resize(front_ + newSampleCount);
     setFrameRate(getFrameRate() / factor);
 }
 
@@ -237,10 +247,36 @@ void AudioData::discardFramesFromFront(unsigned int discardFrameCount)
         ss << "Cannot discard " << discardFrameCount << " frames of " << getFrameCount();
         throw Exception(ss.str().c_str());
     }
-    unsigned int discardSampleCount = discardFrameCount * channels_;
-    auto discardToHere = samples_.begin();
-    std::advance(discardToHere, discardSampleCount);
-    samples_.erase(samples_.begin(), discardToHere);
+    front_ += discardFrameCount * channels_;
+    if (front_ == samples_.size()) {
+        samples_.clear();
+        front_ = 0;
+    } else if (front_ > getSampleCount()) {
+        // compact once the dead space outweighs the live samples, so each
+        // sample is moved at most a constant number of times on average
+        samples_.erase(samples_.begin(), samples_.begin() + front_);
+        front_ = 0;
+    }
+}
+
+void AudioData::discardFramesFromBack(unsigned int discardFrameCount)
+{
+    if (discardFrameCount > getFrameCount()) {
+        std::ostringstream ss;
+        ss << "Cannot discard " << discardFrameCount << " frames of " << getFrameCount();
+        throw Exception(ss.str().c_str());
+    }
+    samples_.resize(samples_.size() - (discardFrameCount * channels_));
+}
+
+void AudioData::clear()
+{
+    samples_.clear();
+    front_ = 0;
+    channels_ = 0;
+    frameRate_ = 0;
+    readIndex_ = 0;
+    writeIndex_ = 0;
 }
 
 auto AudioData::sliceSamplesFromBack(unsigned int sliceSampleCount) -> AudioData*
@@ -259,54 +295,47 @@ auto AudioData::sliceSamplesFromBack(unsigned int sliceSampleCount) -> AudioData
     that->setFrameRate(getFrameRate());
     that->addToSampleCount(sliceSampleCount);
 
-    auto readAt = samples_.begin();
-    std::advance(readAt, samplesToLeaveIntact);
-    auto writeAt = that->samples_.begin();
-    while (readAt < samples_.end()) {
-        *writeAt = *readAt;
-        std::advance(readAt, 1);
-        std::advance(writeAt, 1);
-    }
+    std::copy(getSampleData() + samplesToLeaveIntact, getSampleData() + getSampleCount(), that->getSampleData());
 
-    samples_.resize(samplesToLeaveIntact);
+    samples_.resize(front_ + samplesToLeaveIntact);
 
     return that;
 }
 
 void AudioData::resetIterators()
 {
-    readIterator_ = samples_.begin();
-    writeIterator_ = samples_.begin();
+    readIndex_ = 0;
+    writeIndex_ = 0;
 }
 
 auto AudioData::readIteratorWithinUpperBound() const -> bool
 {
-    return (readIterator_ < samples_.end());
+    return (readIndex_ < getSampleCount());
 }
 
 auto AudioData::writeIteratorWithinUpperBound() const -> bool
 {
-    return (writeIterator_ < samples_.end());
+    return (writeIndex_ < getSampleCount());
 }
 
 void AudioData::advanceReadIterator(unsigned int by)
 {
-    std::advance(readIterator_, by);
+    readIndex_ += by;
 }
 
 void AudioData::advanceWriteIterator(unsigned int by)
 {
-    std::advance(writeIterator_, by);
+    writeIndex_ += by;
 }
 
 auto AudioData::getSampleAtReadIterator() const -> float
 {
-    return *readIterator_;
+    return samples_[front_ + readIndex_];
 }
 
 void AudioData::setSampleAtWriteIterator(float value)
 {
-    *writeIterator_ = value;
+    samples_[front_ + writeIndex_] = value;
 }
 
 }
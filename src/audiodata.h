@@ -38,6 +38,11 @@ public:
     [[nodiscard]] auto getSampleCount() const -> unsigned int;
     [[nodiscard]] auto getFrameCount() const -> unsigned int;
 
+    // Contiguous view of all samples, valid until the next call that changes
+    // the sample count. Pair with getSampleCount() to walk the buffer directly.
+    [[nodiscard]] auto getSampleData() const -> const float*;
+    [[nodiscard]] auto getSampleData() -> float*;
+
     void setChannels(unsigned int inChannels);
     void setFrameRate(unsigned int inFrameRate);
     void setSample(unsigned int index, float value);
@@ -55,16 +60,23 @@ public:
     void append(const AudioData& that);
     void prepend(const AudioData& that);
     void discardFramesFromFront(unsigned int discardFrameCount);
+    void discardFramesFromBack(unsigned int discardFrameCount);
     void reduceToMono();
     void downsample(unsigned int factor, bool shortcut = true);
     auto sliceSamplesFromBack(unsigned int sliceSampleCount) -> AudioData*;
+    // Back to the default-constructed state, keeping the allocation.
+    void clear();
 
 private:
-    std::deque<float> samples_;
+    // Samples live in samples_[front_, samples_.size()). Discarding from the
+    // front just moves front_ along; the dead space is reclaimed lazily once it
+    // outgrows the live samples, which keeps discards amortised O(1).
+    std::vector<float> samples_;
+    unsigned int front_ { 0 };
     unsigned int channels_ { 0 };
     unsigned int frameRate_ { 0 };
-    std::deque<float>::const_iterator readIterator_;
-    std::deque<float>::iterator writeIterator_;
+    unsigned int readIndex_ { 0 };
+    unsigned int writeIndex_ { 0 };
 };
 
 }
@@ -0,0 +1,279 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "audioview.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace KeyFinder {
+
+// Each format reads one sample from raw bytes; scale maps its full range onto
+// [-1, 1). The loads go through memcpy so that unaligned buffers are fine and
+// the compiler still sees plain loads it can vectorise. Only floating-point
+// formats can hold NaN or infinity.
+class Float32Samples {
+public:
+    static constexpr unsigned int size = 4;
+    static constexpr float scale = 1.0f;
+    static constexpr bool floating = true;
+    static auto load(const unsigned char* p) -> float
+    {
+        float v;
+        memcpy(&v, p, size);
+        return v;
+    }
+};
+
+class Float64Samples {
+public:
+    static constexpr unsigned int size = 8;
+    static constexpr float scale = 1.0f;
+    static constexpr bool floating = true;
+    static auto load(const unsigned char* p) -> float
+    {
+        double v;
+        memcpy(&v, p, size);
+        return (float)v;
+    }
+};
+
+class Int16Samples {
+public:
+    static constexpr unsigned int size = 2;
+    static constexpr float scale = 1.0f / 32768.0f;
+    static constexpr bool floating = false;
+    static auto load(const unsigned char* p) -> float
+    {
+        int16_t v;
+        memcpy(&v, p, size);
+        return v;
+    }
+};
+
+class Int32Samples {
+public:
+    static constexpr unsigned int size = 4;
+    static constexpr float scale = 1.0f / 2147483648.0f;
+    static constexpr bool floating = false;
+    static auto load(const unsigned char* p) -> float
+    {
+        int32_t v;
+        memcpy(&v, p, size);
+        return (float)v;
+    }
+};
+
+class Int24Samples {
+public:
+    static constexpr unsigned int size = 3;
+    static constexpr float scale = 1.0f / 8388608.0f;
+    static constexpr bool floating = false;
+    static auto load(const unsigned char* p) -> float
+    {
+        // assemble in the top three bytes, then shift down to sign-extend
+        auto v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24));
+        return (float)(v >> 8);
+    }
+};
+
+class UInt8Samples {
+public:
+    static constexpr unsigned int size = 1;
+    static constexpr float scale = 1.0f / 128.0f;
+    static constexpr bool floating = false;
+    static auto load(const unsigned char* p) -> float
+    {
+        return (float)p[0] - 128.0f;
+    }
+};
+
+// Mono and all-of-stereo input get loops with a fixed stride, which compilers
+// turn into SIMD conversion; anything else sums the selected channels.
+template <typename Samples>
+static void downmixInterleaved(const unsigned char* input, unsigned int frameCount, unsigned int channels, const std::vector<unsigned int>& selected, float* destination)
+{
+    const unsigned int s = Samples::size;
+    if (selected.empty() && channels == 1) {
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            destination[frame] = Samples::load(input + ((size_t)frame * s)) * Samples::scale;
+        }
+    } else if (selected.empty() && channels == 2) {
+        const float scale = Samples::scale / 2;
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            const unsigned char* p = input + ((size_t)frame * 2 * s);
+            destination[frame] = (Samples::load(p) + Samples::load(p + s)) * scale;
+        }
+    } else if (selected.size() == 1) {
+        const size_t frameBytes = (size_t)channels * s;
+        input += (size_t)selected[0] * s;
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            destination[frame] = Samples::load(input + (frame * frameBytes)) * Samples::scale;
+        }
+    } else {
+        const size_t frameBytes = (size_t)channels * s;
+        const unsigned int count = selected.empty() ? channels : selected.size();
+        // fold the channel average into the format scale factor
+        const float scale = Samples::scale / count;
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            const unsigned char* p = input + (frame * frameBytes);
+            float sum = 0.0;
+            for (unsigned int c = 0; c < count; c++) {
+                sum += Samples::load(p + ((size_t)(selected.empty() ? c : selected[c]) * s));
+            }
+            destination[frame] = sum * scale;
+        }
+    }
+    // checked after conversion, which keeps the loops above branch-free
+    if (Samples::floating) {
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            if (!std::isfinite(destination[frame])) {
+                throw Exception("Cannot set sample to NaN");
+            }
+        }
+    }
+}
+
+AudioView::AudioView(const void* data, unsigned int frameCount, unsigned int channels, unsigned int frameRate, SampleFormatT format)
+    : data_(data)
+    , frameCount_(frameCount)
+    , channels_(channels)
+    , frameRate_(frameRate)
+    , format_(format)
+{
+    if (channels < 1) {
+        throw Exception("Channels must be > 0");
+    }
+    if (frameRate < 1) {
+        throw Exception("Frame rate must be > 0");
+    }
+    if (data == nullptr && frameCount > 0) {
+        throw Exception("Audio view has no data");
+    }
+}
+
+auto AudioView::getData() const -> const void*
+{
+    return data_;
+}
+
+auto AudioView::getFrameCount() const -> unsigned int
+{
+    return frameCount_;
+}
+
+auto AudioView::getChannels() const -> unsigned int
+{
+    return channels_;
+}
+
+auto AudioView::getFrameRate() const -> unsigned int
+{
+    return frameRate_;
+}
+
+auto AudioView::getSampleFormat() const -> SampleFormatT
+{
+    return format_;
+}
+
+auto AudioView::getSampleSize(SampleFormatT format) -> unsigned int
+{
+    switch (format) {
+    case SAMPLE_FORMAT_INT16:
+        return Int16Samples::size;
+    case SAMPLE_FORMAT_INT32:
+        return Int32Samples::size;
+    case SAMPLE_FORMAT_INT24:
+        return Int24Samples::size;
+    case SAMPLE_FORMAT_UINT8:
+        return UInt8Samples::size;
+    case SAMPLE_FORMAT_FLOAT64:
+        return Float64Samples::size;
+    case SAMPLE_FORMAT_FLOAT32:
+    default:
+        return Float32Samples::size;
+    }
+}
+
+void AudioView::selectChannels(const std::vector<unsigned int>& channels)
+{
+    for (unsigned int channel : channels) {
+        if (channel >= channels_) {
+            std::ostringstream ss;
+            ss << "Cannot select out-of-bounds channel (" << channel << "/" << channels_ << ")";
+            throw Exception(ss.str().c_str());
+        }
+    }
+    selectedChannels_ = channels;
+}
+
+auto AudioView::getSelectedChannels() const -> const std::vector<unsigned int>&
+{
+    return selectedChannels_;
+}
+
+auto AudioView::subView(unsigned int firstFrame, unsigned int frameCount) const -> AudioView
+{
+    if (firstFrame > frameCount_ || frameCount > frameCount_ - firstFrame) {
+        std::ostringstream ss;
+        ss << "Cannot view out-of-bounds frames (" << (unsigned long long)firstFrame + frameCount << "/" << frameCount_ << ")";
+        throw Exception(ss.str().c_str());
+    }
+    const unsigned char* first = (const unsigned char*)data_ + ((size_t)firstFrame * channels_ * getSampleSize(format_));
+    AudioView view(frameCount == 0 ? data_ : first, frameCount, channels_, frameRate_, format_);
+    view.selectedChannels_ = selectedChannels_;
+    return view;
+}
+
+void AudioView::downmix(unsigned int firstFrame, unsigned int frameCount, float* destination) const
+{
+    if (frameCount > frameCount_ || firstFrame > frameCount_ - frameCount) {
+        std::ostringstream ss;
+        ss << "Cannot downmix out-of-bounds frames (" << (unsigned long long)firstFrame + frameCount << "/" << frameCount_ << ")";
+        throw Exception(ss.str().c_str());
+    }
+    const unsigned char* input = (const unsigned char*)data_ + ((size_t)firstFrame * channels_ * getSampleSize(format_));
+    switch (format_) {
+    case SAMPLE_FORMAT_INT16:
+        downmixInterleaved<Int16Samples>(input, frameCount, channels_, selectedChannels_, destination);
+        break;
+    case SAMPLE_FORMAT_INT32:
+        downmixInterleaved<Int32Samples>(input, frameCount, channels_, selectedChannels_, destination);
+        break;
+    case SAMPLE_FORMAT_INT24:
+        downmixInterleaved<Int24Samples>(input, frameCount, channels_, selectedChannels_, destination);
+        break;
+    case SAMPLE_FORMAT_UINT8:
+        downmixInterleaved<UInt8Samples>(input, frameCount, channels_, selectedChannels_, destination);
+        break;
+    case SAMPLE_FORMAT_FLOAT64:
+        downmixInterleaved<Float64Samples>(input, frameCount, channels_, selectedChannels_, destination);
+        break;
+    case SAMPLE_FORMAT_FLOAT32:
+    default:
+        downmixInterleaved<Float32Samples>(input, frameCount, channels_, selectedChannels_, destination);
+        break;
+    }
+}
+
+}
@@ -0,0 +1,69 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef AUDIOVIEW_H
+#define AUDIOVIEW_H
+
+#include "constants.h"
+
+namespace KeyFinder {
+
+// A read-only window onto interleaved PCM owned by the caller. Nothing is
+// copied on construction; the memory must outlive any call the view is
+// passed to.
+class AudioView {
+public:
+    AudioView(const void* data, unsigned int frameCount, unsigned int channels, unsigned int frameRate, SampleFormatT format = SAMPLE_FORMAT_FLOAT32);
+
+    [[nodiscard]] auto getData() const -> const void*;
+    [[nodiscard]] auto getFrameCount() const -> unsigned int;
+    [[nodiscard]] auto getChannels() const -> unsigned int;
+    [[nodiscard]] auto getFrameRate() const -> unsigned int;
+    [[nodiscard]] auto getSampleFormat() const -> SampleFormatT;
+    [[nodiscard]] static auto getSampleSize(SampleFormatT format) -> unsigned int;
+
+    // Restricts analysis to some of the channels, e.g. one stem of a
+    // multichannel file. An empty selection means every channel.
+    void selectChannels(const std::vector<unsigned int>& channels);
+    [[nodiscard]] auto getSelectedChannels() const -> const std::vector<unsigned int>&;
+
+    // A view of frameCount frames starting at firstFrame, with the same
+    // format and channel selection.
+    [[nodiscard]] auto subView(unsigned int firstFrame, unsigned int frameCount) const -> AudioView;
+
+    // Averages the selected channels of frameCount frames starting at
+    // firstFrame into destination, one float per frame. Integer formats are
+    // scaled to [-1, 1); floating-point input that isn't finite throws, as
+    // AudioData::setSample does.
+    void downmix(unsigned int firstFrame, unsigned int frameCount, float* destination) const;
+
+private:
+    const void* data_;
+    unsigned int frameCount_;
+    unsigned int channels_;
+    unsigned int frameRate_;
+    SampleFormatT format_;
+    std::vector<unsigned int> selectedChannels_;
+};
+
+}
+
+#endif
@@ -21,10 +21,14 @@
 
 #include "chromagram.h"
 
+#include <algorithm>
+
 namespace KeyFinder {
 
 Chromagram::Chromagram(unsigned int hops)
-    : chromaData_(hops, std::vector<float>(BANDS, 0.0))
+    : chromaData_((size_t)hops * BANDS, 0.0)
+    , bandTotals_(BANDS, 0.0)
+    , hopCount_(hops)
 {
 }
 
@@ -40,7 +44,19 @@ auto Chromagram::getMagnitude(unsigned int hop, unsigned int band) const -> floa
         ss << "Cannot get magnitude of out-of-bounds band (" << band << "/" << BANDS << ")";
         throw Exception(ss.str().c_str());
     }
-    return chromaData_[hop][band];
+    checkRetained(hop, "get magnitude of");
+    return chromaData_[row(hop) + band];
+}
+
+auto Chromagram::getHop(unsigned int hop) const -> const float*
+{
+    if (hop >= getHops()) {
+        std::ostringstream ss;
+        ss << "Cannot get out-of-bounds hop (" << hop << "/" << getHops() << ")";
+        throw Exception(ss.str().c_str());
+    }
+    checkRetained(hop, "get");
+    return chromaData_.data() + row(hop);
 }
 
 void Chromagram::setMagnitude(unsigned int hop, unsigned int band, float value)
@@ -58,28 +74,136 @@ void Chromagram::setMagnitude(unsigned int hop, unsigned int band, float value)
     if (!std::isfinite(value)) {
         throw Exception("Cannot set magnitude to NaN");
     }
-    chromaData_[hop][band] = value;
+    checkRetained(hop, "set magnitude of");
+    float& magnitude = chromaData_[row(hop) + band];
+    bandTotals_[band] += (double)value - magnitude;
+    magnitude = value;
 }
 
-auto Chromagram::collapseToOneHop() const -> std::vector<float>
+void Chromagram::setHop(unsigned int hop, const float* values)
 {
-    std::vector<float> oneHop = std::vector<float>(BANDS, 0.0);
-    for (unsigned int h = 0; h < getHops(); h++) {
-        for (unsigned int b = 0; b < BANDS; b++) {
-            oneHop[b] += getMagnitude(h, b) / getHops();
+    if (hop >= getHops()) {
+        std::ostringstream ss;
+        ss << "Cannot set out-of-bounds hop (" << hop << "/" << getHops() << ")";
+        throw Exception(ss.str().c_str());
+    }
+    checkRetained(hop, "set");
+    checkFinite(values);
+    float* stored = chromaData_.data() + row(hop);
+    for (unsigned int b = 0; b < BANDS; b++) {
+        bandTotals_[b] += (double)values[b] - stored[b];
+        stored[b] = values[b];
+    }
+}
+
+void Chromagram::appendHop(const float* values)
+{
+    checkFinite(values);
+    chromaData_.insert(chromaData_.end(), values, values + BANDS);
+    for (unsigned int b = 0; b < BANDS; b++) {
+        bandTotals_[b] += values[b];
+    }
+    hopCount_++;
+    discardOldHops();
+}
+
+void Chromagram::checkFinite(const float* values)
+{
+    for (unsigned int b = 0; b < BANDS; b++) {
+        if (!std::isfinite(values[b])) {
+            throw Exception("Cannot set magnitude to NaN");
         }
     }
+}
+
+void Chromagram::checkRetained(unsigned int hop, const char* action) const
+{
+    if (hop < getFirstRetainedHop()) {
+        std::ostringstream ss;
+        ss << "Cannot " << action << " discarded hop (" << hop << "/" << getFirstRetainedHop() << ")";
+        throw Exception(ss.str().c_str());
+    }
+}
+
+auto Chromagram::row(unsigned int hop) const -> size_t
+{
+    return (size_t)(hop - firstStoredHop_) * BANDS;
+}
+
+auto Chromagram::collapseToOneHop() const -> std::vector<float>
+{
+    std::vector<float> oneHop = std::vector<float>(BANDS, 0.0);
+    collapseToOneHop(oneHop.data());
     return oneHop;
 }
 
+void Chromagram::collapseToOneHop(float* oneHop) const
+{
+    for (unsigned int b = 0; b < BANDS; b++) {
+        oneHop[b] = getHops() == 0 ? 0.0 : bandTotals_[b] / getHops();
+    }
+}
+
 void Chromagram::append(const Chromagram& that)
 {
-    chromaData_.insert(chromaData_.end(), that.chromaData_.begin(), that.chromaData_.end());
+    unsigned int thatFirst = that.getFirstRetainedHop();
+    if (thatFirst > 0) {
+        // the hops stored here wouldn't be contiguous with those appended
+        chromaData_.clear();
+        firstStoredHop_ = hopCount_ + thatFirst;
+    }
+    chromaData_.insert(chromaData_.end(), that.chromaData_.begin() + that.row(thatFirst), that.chromaData_.end());
+    for (unsigned int b = 0; b < BANDS; b++) {
+        bandTotals_[b] += that.bandTotals_[b];
+    }
+    hopCount_ += that.hopCount_;
+    discardOldHops();
+}
+
+void Chromagram::clear()
+{
+    chromaData_.clear();
+    std::fill(bandTotals_.begin(), bandTotals_.end(), 0.0);
+    hopCount_ = 0;
+    firstStoredHop_ = 0;
+}
+
+void Chromagram::retainRecentHops(unsigned int hops)
+{
+    bounded_ = true;
+    retainedHops_ = hops;
+    discardOldHops();
+}
+
+void Chromagram::retainAllHops()
+{
+    bounded_ = false;
+}
+
+auto Chromagram::getFirstRetainedHop() const -> unsigned int
+{
+    if (bounded_ && hopCount_ - firstStoredHop_ > retainedHops_) {
+        return hopCount_ - retainedHops_;
+    }
+    return firstStoredHop_;
+}
+
+// Dropped hops are erased in bulk once they outnumber the retained ones (or
+// a minimum batch), keeping the cost per appended hop constant.
+void Chromagram::discardOldHops()
+{
+    const unsigned int minimumDiscard = 64;
+    unsigned int discardable = getFirstRetainedHop() - firstStoredHop_;
+    if (discardable == 0 || discardable < std::max(retainedHops_, minimumDiscard)) {
+        return;
+    }
+    chromaData_.erase(chromaData_.begin(), chromaData_.begin() + row(getFirstRetainedHop()));
+    firstStoredHop_ += discardable;
 }
 
 auto Chromagram::getHops() const -> unsigned int
 {
-    return chromaData_.size();
+    return hopCount_;
 }
 
 }
@@ -26,17 +26,47 @@
 
 namespace KeyFinder {
 
+// Hops are stored row by row in one contiguous buffer, alongside running
+// totals per band so that collapsing the time dimension doesn't revisit them.
+// For open-ended streams the stored hops can be limited to the most recent
+// few; the totals still cover every hop, so the collapsed chromagram is
+// unaffected. Hops keep their index when older ones are dropped.
 class Chromagram {
 public:
     Chromagram(unsigned int hops = 0);
     void append(const Chromagram& that);
     void setMagnitude(unsigned int hop, unsigned int band, float value);
+    // Bulk row writes; values holds BANDS magnitudes.
+    void setHop(unsigned int hop, const float* values);
+    void appendHop(const float* values);
     [[nodiscard]] auto getMagnitude(unsigned int hop, unsigned int band) const -> float;
+    [[nodiscard]] auto getHop(unsigned int hop) const -> const float*;
     [[nodiscard]] auto getHops() const -> unsigned int;
     [[nodiscard]] auto collapseToOneHop() const -> std::vector<float>;
+    // As above, into BANDS floats without allocating.
+    void collapseToOneHop(float* oneHop) const;
+    // Removes every hop, keeping the allocation and the retention limit.
+    void clear();
+
+    // Keeps at most hops of the latest hops (possibly none) from now on, so
+    // memory no longer grows with the length of the stream.
+    void retainRecentHops(unsigned int hops);
+    void retainAllHops();
+    // Index of the oldest hop that can still be read or written.
+    [[nodiscard]] auto getFirstRetainedHop() const -> unsigned int;
 
 private:
-    std::vector<std::vector<float>> chromaData_;
+    static void checkFinite(const float* values);
+    void checkRetained(unsigned int hop, const char* action) const;
+    [[nodiscard]] auto row(unsigned int hop) const -> size_t;
+    void discardOldHops();
+    std::vector<float> chromaData_;
+    std::vector<double> bandTotals_;
+    unsigned int hopCount_ { 0 };
+    // index of the hop held in the first row of chromaData_
+    unsigned int firstStoredHop_ { 0 };
+    bool bounded_ { false };
+    unsigned int retainedHops_ { 0 };
 };
 
 }
@@ -21,9 +21,11 @@
 
 #include "chromatransform.h"
 
+#include "vectorops.h"
+
 namespace KeyFinder {
 
-ChromaTransform::ChromaTransform(unsigned int inFrameRate)
+ChromaTransform::ChromaTransform(unsigned int inFrameRate, unsigned int frameSize)
 {
 
     frameRate = inFrameRate;
@@ -35,18 +37,22 @@ ChromaTransform::ChromaTransform(unsigned int inFrameRate)
         throw Exception("Analysis frequencies over Nyquist");
     }
 
-    if (frameRate / (float)FFTFRAMESIZE > (getFrequencyOfBand(1) - getFrequencyOfBand(0))) {
+    if (frameSize < 1) {
+        throw Exception("Frame size must be > 0");
+    }
+
+    if (frameRate / (float)frameSize > (getFrequencyOfBand(1) - getFrequencyOfBand(0))) {
         throw Exception("Insufficient low-end resolution");
     }
 
     chromaBandFftBinOffsets.resize(BANDS, 0);
-    directSpectralKernel.resize(BANDS, std::vector<float>(0, 0.0));
+    kernelBandOffsets.resize(BANDS + 1, 0);
 
     float myQFactor = DIRECTSKSTRETCH * (pow(2, (1.0 / SEMITONES)) - 1);
 
     for (unsigned int i = 0; i < BANDS; i++) {
 
-        float centreOfWindow = getFrequencyOfBand(i) * FFTFRAMESIZE / inFrameRate;
+        float centreOfWindow = getFrequencyOfBand(i) * frameSize / inFrameRate;
         float widthOfWindow = centreOfWindow * myQFactor;
         float beginningOfWindow = centreOfWindow - (widthOfWindow / 2);
         float endOfWindow = beginningOfWindow + widthOfWindow;
@@ -54,17 +60,23 @@ ChromaTransform::ChromaTransform(unsigned int inFrameRate)
         float sumOfCoefficients = 0.0;
 
         chromaBandFftBinOffsets[i] = ceil(beginningOfWindow); // first useful fft bin
+        kernelBandOffsets[i] = directSpectralKernel.size();
         for (unsigned int fftBin = chromaBandFftBinOffsets[i]; fftBin <= floor(endOfWindow); fftBin++) {
             float coefficient = kernelWindow(fftBin - beginningOfWindow, widthOfWindow);
             sumOfCoefficients += coefficient;
-            directSpectralKernel[i].push_back(coefficient);
+            directSpectralKernel.push_back(coefficient);
         }
+        kernelBandOffsets[i + 1] = directSpectralKernel.size();
 
         // normalisation by sum of coefficients and frequency of bin; models CQT very closely
-        for (unsigned int j = 0; j < directSpectralKernel[i].size(); j++) {
-            directSpectralKernel[i][j] = directSpectralKernel[i][j] / sumOfCoefficients * getFrequencyOfBand(i);
+        for (unsigned int j = kernelBandOffsets[i]; j < kernelBandOffsets[i + 1]; j++) {
+            directSpectralKernel[j] = directSpectralKernel[j] / sumOfCoefficients * getFrequencyOfBand(i);
         }
     }
+
+    // bands widen with frequency, so the highest band reaches furthest
+    firstFftBin = chromaBandFftBinOffsets[0];
+    fftBinCount = chromaBandFftBinOffsets[BANDS - 1] + (kernelBandOffsets[BANDS] - kernelBandOffsets[BANDS - 1]) - firstFftBin;
 }
 
 auto ChromaTransform::kernelWindow(float n, float nn) -> float
@@ -73,18 +85,21 @@ auto ChromaTransform::kernelWindow(float n, float nn) -> float
     return 1.0 - cos((2 * PI * n) / nn);
 }
 
-auto ChromaTransform::chromaVector(const FftAdapter* const fftAdapter) const -> std::vector<float>
+void ChromaTransform::chromaVector(const FftAdapter* const fftAdapter, unsigned int transform, float* chromaVector) const
 {
-    std::vector<float> chromaVector(BANDS);
+    // one pass for every magnitude any band needs, shared by overlapping bands
+    const float* magnitudes = fftAdapter->getOutputMagnitudes(transform, firstFftBin, fftBinCount) - firstFftBin;
     for (unsigned int i = 0; i < BANDS; i++) {
-        float sum = 0.0;
-        for (unsigned int j = 0; j < directSpectralKernel[i].size(); j++) {
-            float magnitude = fftAdapter->getOutputMagnitude(chromaBandFftBinOffsets[i] + j);
-            sum += (magnitude * directSpectralKernel[i][j]);
-        }
-        chromaVector[i] = sum;
+        unsigned int kernelLength = kernelBandOffsets[i + 1] - kernelBandOffsets[i];
+        chromaVector[i] = dotProduct(directSpectralKernel.data() + kernelBandOffsets[i], magnitudes + chromaBandFftBinOffsets[i], kernelLength);
     }
-    return chromaVector;
+}
+
+auto ChromaTransform::chromaVector(const FftAdapter* const fftAdapter, unsigned int transform) const -> std::vector<float>
+{
+    std::vector<float> cv(BANDS);
+    chromaVector(fftAdapter, transform, cv.data());
+    return cv;
 }
 
 }
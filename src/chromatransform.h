@@ -29,13 +29,23 @@ namespace KeyFinder {
 
 class ChromaTransform {
 public:
-    ChromaTransform(unsigned int frameRate);
-    auto chromaVector(const FftAdapter* fft) const -> std::vector<float>;
+    // The kernel maps the bins of frameSize-point FFTs onto the chroma bands.
+    ChromaTransform(unsigned int frameRate, unsigned int frameSize = FFTFRAMESIZE);
+    // Writes BANDS values to chromaVector.
+    void chromaVector(const FftAdapter* fft, unsigned int transform, float* chromaVector) const;
+    auto chromaVector(const FftAdapter* fft, unsigned int transform = 0) const -> std::vector<float>;
 
 protected:
     unsigned int frameRate;
-    std::vector<std::vector<float>> directSpectralKernel;
+    // The direct spectral kernel is stored as a packed sparse matrix: band i
+    // weights the FFT bins from chromaBandFftBinOffsets[i] onwards with the
+    // coefficients directSpectralKernel[kernelBandOffsets[i]] up to (but not
+    // including) directSpectralKernel[kernelBandOffsets[i + 1]].
+    std::vector<float> directSpectralKernel;
+    std::vector<unsigned int> kernelBandOffsets;
     std::vector<unsigned int> chromaBandFftBinOffsets;
+    unsigned int firstFftBin;
+    unsigned int fftBinCount;
     [[nodiscard]] static auto kernelWindow(float n, float nn) -> float;
 };
 
@@ -23,8 +23,9 @@
 
 namespace KeyFinder {
 
-ChromaTransformFactory::ChromaTransformWrapper::ChromaTransformWrapper(unsigned int inFrameRate, const ChromaTransform* const inChromaTransform)
+ChromaTransformFactory::ChromaTransformWrapper::ChromaTransformWrapper(unsigned int inFrameRate, unsigned int inFrameSize, const ChromaTransform* const inChromaTransform)
     : frameRate_(inFrameRate)
+    , frameSize_(inFrameSize)
     , chromaTransform_(inChromaTransform)
 {
 }
@@ -44,30 +45,18 @@ auto ChromaTransformFactory::ChromaTransformWrapper::getFrameRate() const -> uns
     return frameRate_;
 }
 
-ChromaTransformFactory::ChromaTransformFactory()
-    : chromaTransforms_(0)
+auto ChromaTransformFactory::ChromaTransformWrapper::getFrameSize() const -> unsigned int
 {
+    return frameSize_;
 }
 
-ChromaTransformFactory::~ChromaTransformFactory()
+auto ChromaTransformFactory::getChromaTransform(unsigned int frameRate, unsigned int frameSize) -> const ChromaTransform*
 {
-    for (auto& chromaTransform : chromaTransforms_) {
-        delete chromaTransform;
-    }
-}
-
-auto ChromaTransformFactory::getChromaTransform(unsigned int frameRate) -> const ChromaTransform*
-{
-    for (auto* wrapper : chromaTransforms_) {
-        if (wrapper->getFrameRate() == frameRate) {
-            return wrapper->getChromaTransform();
-        }
-    }
-    chromaTransformFactoryMutex_.lock();
-    chromaTransforms_.push_back(new ChromaTransformWrapper(frameRate, new ChromaTransform(frameRate)));
-    unsigned int newChromaTransformIndex = chromaTransforms_.size() - 1;
-    chromaTransformFactoryMutex_.unlock();
-    return chromaTransforms_[newChromaTransformIndex]->getChromaTransform();
+    return chromaTransforms_.find([&](const ChromaTransformWrapper& wrapper) {
+        return wrapper.getFrameRate() == frameRate && wrapper.getFrameSize() == frameSize;
+    }, [&]() {
+        return new ChromaTransformWrapper(frameRate, frameSize, new ChromaTransform(frameRate, frameSize));
+    })->getChromaTransform();
 }
 
 }
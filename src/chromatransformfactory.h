@@ -24,30 +24,30 @@
 
 #include "chromatransform.h"
 #include "constants.h"
+#include "snapshotcache.h"
 
 namespace KeyFinder {
 
 class ChromaTransformFactory {
 public:
-    ChromaTransformFactory();
-    ~ChromaTransformFactory();
-    auto getChromaTransform(unsigned int frameRate) -> const ChromaTransform*;
+    auto getChromaTransform(unsigned int frameRate, unsigned int frameSize = FFTFRAMESIZE) -> const ChromaTransform*;
 
 private:
     class ChromaTransformWrapper;
-    std::vector<ChromaTransformWrapper*> chromaTransforms_;
-    std::mutex chromaTransformFactoryMutex_;
+    SnapshotCache<ChromaTransformWrapper> chromaTransforms_;
 };
 
 class ChromaTransformFactory::ChromaTransformWrapper {
 public:
-    ChromaTransformWrapper(unsigned int frameRate, const ChromaTransform* transform);
+    ChromaTransformWrapper(unsigned int frameRate, unsigned int frameSize, const ChromaTransform* transform);
     ~ChromaTransformWrapper();
     [[nodiscard]] auto getChromaTransform() const -> const ChromaTransform*;
     [[nodiscard]] auto getFrameRate() const -> unsigned int;
+    [[nodiscard]] auto getFrameSize() const -> unsigned int;
 
 private:
     unsigned int frameRate_;
+    unsigned int frameSize_;
     const ChromaTransform* const chromaTransform_;
 };
 
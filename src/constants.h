@@ -52,6 +52,9 @@
 #undef HOPSIZE
 #define HOPSIZE (FFTFRAMESIZE / 4)
 
+#undef FFTBATCHSIZE
+#define FFTBATCHSIZE 4 // hops transformed per FFTW call during whole-track analysis
+
 #undef DIRECTSKSTRETCH
 #define DIRECTSKSTRETCH 0.8
 
@@ -95,6 +98,32 @@ enum ScaleT {
     SCALE_MINOR
 };
 
+// The preprocessing stage covers downmixing, low pass filtering and
+// decimation, which run as a single fused pass.
+enum AnalysisStageT {
+    STAGE_PREPROCESS,
+    STAGE_WINDOWING,
+    STAGE_FFT,
+    STAGE_CHROMA,
+    STAGE_CLASSIFICATION
+};
+
+enum FftPlanningT {
+    FFT_PLANNING_ESTIMATE,
+    FFT_PLANNING_MEASURE,
+    FFT_PLANNING_PATIENT
+};
+
+// Integer formats are signed and native-endian except where noted.
+enum SampleFormatT {
+    SAMPLE_FORMAT_FLOAT32,
+    SAMPLE_FORMAT_INT16,
+    SAMPLE_FORMAT_INT32,
+    SAMPLE_FORMAT_INT24, // packed in 3 bytes, little-endian, as in WAV files
+    SAMPLE_FORMAT_UINT8, // unsigned, centred on 128, as in WAV files
+    SAMPLE_FORMAT_FLOAT64
+};
+
 auto getFrequencyOfBand(unsigned int band) -> float;
 auto getLastFrequency() -> float;
 
@@ -22,6 +22,7 @@
 #include "fftadapter.h"
 
 // Included here to allow substitution of a separate implementation .cpp
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <fftw3.h>
@@ -29,29 +30,92 @@
 namespace KeyFinder {
 
 std::mutex fftwPlanMutex;
+static std::atomic<FftPlanningT> fftPlanning(FFT_PLANNING_ESTIMATE);
+
+static auto fftwPlanningFlags() -> unsigned int
+{
+    switch (fftPlanning.load()) {
+    case FFT_PLANNING_MEASURE:
+        return FFTW_MEASURE;
+    case FFT_PLANNING_PATIENT:
+        return FFTW_PATIENT;
+    default:
+        return FFTW_ESTIMATE;
+    }
+}
+
+void setFftPlanning(FftPlanningT planning)
+{
+    fftPlanning = planning;
+}
+
+auto getFftPlanning() -> FftPlanningT
+{
+    return fftPlanning;
+}
+
+auto importFftWisdom(const std::string& path) -> bool
+{
+    std::lock_guard<std::mutex> lock(fftwPlanMutex);
+    return fftwf_import_wisdom_from_filename(path.c_str()) != 0;
+}
+
+auto exportFftWisdom(const std::string& path) -> bool
+{
+    std::lock_guard<std::mutex> lock(fftwPlanMutex);
+    return fftwf_export_wisdom_to_filename(path.c_str()) != 0;
+}
+
+void forgetFftWisdom()
+{
+    std::lock_guard<std::mutex> lock(fftwPlanMutex);
+    fftwf_forget_wisdom();
+}
 
 class FftAdapterPrivate {
 public:
     float* inputReal;
     fftwf_complex* outputComplex;
     fftwf_plan plan;
+    fftwf_plan batchPlan;
+    std::vector<float> magnitudes;
 };
 
-FftAdapter::FftAdapter(unsigned int inFrameSize)
+FftAdapter::FftAdapter(unsigned int inFrameSize, unsigned int inBatchSize)
     : priv(new FftAdapterPrivate)
 {
+    if (inBatchSize < 1) {
+        throw Exception("FFT batch size must be > 0");
+    }
     frameSize = inFrameSize;
-    priv->inputReal = (float*)fftwf_malloc(sizeof(float) * frameSize);
-    priv->outputComplex = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * frameSize);
-    memset(priv->outputComplex, 0, sizeof(fftwf_complex) * frameSize);
+    batchSize = inBatchSize;
+    // each transform's output keeps a full frameSize of bins, so that the bins
+    // above Nyquist read as zero just as they do for a single transform
+    priv->inputReal = (float*)fftwf_malloc(sizeof(float) * frameSize * batchSize);
+    priv->outputComplex = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * frameSize * batchSize);
+    int n = frameSize;
+    unsigned int flags = fftwPlanningFlags();
     fftwPlanMutex.lock();
-    priv->plan = fftwf_plan_dft_r2c_1d(frameSize, priv->inputReal, priv->outputComplex, FFTW_ESTIMATE);
+    // partial batches run the single plan on each transform's slice, which is
+    // only as aligned as the plan's own buffers when frames are multiples of 4
+    unsigned int singleFlags = batchSize > 1 && frameSize % 4 != 0 ? flags | FFTW_UNALIGNED : flags;
+    priv->plan = fftwf_plan_dft_r2c_1d(frameSize, priv->inputReal, priv->outputComplex, singleFlags);
+    priv->batchPlan = nullptr;
+    if (batchSize > 1) {
+        priv->batchPlan = fftwf_plan_many_dft_r2c(1, &n, batchSize, priv->inputReal, nullptr, 1, n, priv->outputComplex, nullptr, 1, n, flags);
+    }
     fftwPlanMutex.unlock();
+    // measuring plans scribble over the buffers, so clear them afterwards
+    memset(priv->inputReal, 0, sizeof(float) * frameSize * batchSize);
+    memset(priv->outputComplex, 0, sizeof(fftwf_complex) * frameSize * batchSize);
 }
 
 FftAdapter::~FftAdapter()
 {
     fftwf_destroy_plan(priv->plan);
+    if (priv->batchPlan != nullptr) {
+        fftwf_destroy_plan(priv->batchPlan);
+    }
     fftwf_free(priv->inputReal);
     fftwf_free(priv->outputComplex);
     delete priv;
@@ -62,6 +126,11 @@ auto FftAdapter::getFrameSize() const -> unsigned int
     return frameSize;
 }
 
+auto FftAdapter::getBatchSize() const -> unsigned int
+{
+    return batchSize;
+}
+
 void FftAdapter::setInput(unsigned int i, float real)
 {
     if (i >= frameSize) {
@@ -75,6 +144,16 @@ void FftAdapter::setInput(unsigned int i, float real)
     priv->inputReal[i] = real;
 }
 
+auto FftAdapter::getInputBuffer(unsigned int transform) -> float*
+{
+    if (transform >= batchSize) {
+        std::ostringstream ss;
+        ss << "Cannot get out-of-bounds transform (" << transform << "/" << batchSize << ")";
+        throw Exception(ss.str().c_str());
+    }
+    return priv->inputReal + ((size_t)transform * frameSize);
+}
+
 auto FftAdapter::getOutputReal(unsigned int i) const -> float
 {
     if (i >= frameSize) {
@@ -97,12 +176,44 @@ auto FftAdapter::getOutputImaginary(unsigned int i) const -> float
 
 auto FftAdapter::getOutputMagnitude(unsigned int i) const -> float
 {
+    return getOutputMagnitude(0, i);
+}
+
+auto FftAdapter::getOutputMagnitude(unsigned int transform, unsigned int i) const -> float
+{
+    if (transform >= batchSize) {
+        std::ostringstream ss;
+        ss << "Cannot get out-of-bounds transform (" << transform << "/" << batchSize << ")";
+        throw Exception(ss.str().c_str());
+    }
     if (i >= frameSize) {
         std::ostringstream ss;
         ss << "Cannot get out-of-bounds sample (" << i << "/" << frameSize << ")";
         throw Exception(ss.str().c_str());
     }
-    return sqrt(pow(getOutputReal(i), 2) + pow(getOutputImaginary(i), 2));
+    const fftwf_complex& bin = priv->outputComplex[((size_t)transform * frameSize) + i];
+    return sqrt(pow(bin[0], 2) + pow(bin[1], 2));
+}
+
+auto FftAdapter::getOutputMagnitudes(unsigned int transform, unsigned int first, unsigned int count) const -> const float*
+{
+    if (transform >= batchSize) {
+        std::ostringstream ss;
+        ss << "Cannot get out-of-bounds transform (" << transform << "/" << batchSize << ")";
+        throw Exception(ss.str().c_str());
+    }
+    if (first + count > frameSize) {
+        std::ostringstream ss;
+        ss << "Cannot get out-of-bounds sample (" << first + count << "/" << frameSize << ")";
+        throw Exception(ss.str().c_str());
+    }
+    priv->magnitudes.resize(count);
+    const fftwf_complex* bins = priv->outputComplex + ((size_t)transform * frameSize) + first;
+    float* magnitudes = priv->magnitudes.data();
+    for (unsigned int i = 0; i < count; i++) {
+        magnitudes[i] = std::sqrt((bins[i][0] * bins[i][0]) + (bins[i][1] * bins[i][1]));
+    }
+    return magnitudes;
 }
 
 void FftAdapter::execute()
@@ -110,6 +221,24 @@ void FftAdapter::execute()
     fftwf_execute(priv->plan);
 }
 
+void FftAdapter::executeBatch(unsigned int transformCount)
+{
+    if (transformCount > batchSize) {
+        std::ostringstream ss;
+        ss << "Cannot execute more transforms than the batch holds (" << transformCount << "/" << batchSize << ")";
+        throw Exception(ss.str().c_str());
+    }
+    if (transformCount == batchSize && priv->batchPlan != nullptr) {
+        fftwf_execute(priv->batchPlan);
+        return;
+    }
+    // a partial batch reuses the single plan on each transform's slice of the buffers
+    for (unsigned int t = 0; t < transformCount; t++) {
+        size_t offset = (size_t)t * frameSize;
+        fftwf_execute_dft_r2c(priv->plan, priv->inputReal + offset, priv->outputComplex + offset);
+    }
+}
+
 // ================================= INVERSE =================================
 
 class InverseFftAdapterPrivate {
@@ -125,9 +254,11 @@ InverseFftAdapter::InverseFftAdapter(unsigned int inFrameSize)
     frameSize = inFrameSize;
     priv->inputComplex = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * frameSize);
     priv->outputReal = (float*)fftwf_malloc(sizeof(float) * frameSize);
+    unsigned int flags = fftwPlanningFlags();
     fftwPlanMutex.lock();
-    priv->plan = fftwf_plan_dft_c2r_1d(frameSize, priv->inputComplex, priv->outputReal, FFTW_ESTIMATE);
+    priv->plan = fftwf_plan_dft_c2r_1d(frameSize, priv->inputComplex, priv->outputReal, flags);
     fftwPlanMutex.unlock();
+    memset(priv->inputComplex, 0, sizeof(fftwf_complex) * frameSize);
 }
 
 InverseFftAdapter::~InverseFftAdapter()
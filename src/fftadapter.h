@@ -29,19 +29,42 @@ namespace KeyFinder {
 class FftAdapterPrivate;
 class InverseFftAdapterPrivate;
 
+// How thoroughly adapters created from now on choose their FFT algorithms.
+// Measuring is slow, but happens once per transform shape and process; the
+// results can be carried between processes as FFTW wisdom.
+void setFftPlanning(FftPlanningT planning);
+[[nodiscard]] auto getFftPlanning() -> FftPlanningT;
+// Both return false if the file couldn't be read or written.
+auto importFftWisdom(const std::string& path) -> bool;
+auto exportFftWisdom(const std::string& path) -> bool;
+void forgetFftWisdom();
+
+// Holds batchSize independent transforms of frameSize samples each. The
+// per-sample accessors and execute() work on the first transform only;
+// executeBatch() runs several at once through a single FFTW plan.
 class FftAdapter {
 public:
-    FftAdapter(unsigned int frameSize);
+    FftAdapter(unsigned int frameSize, unsigned int batchSize = 1);
     ~FftAdapter();
     [[nodiscard]] auto getFrameSize() const -> unsigned int;
+    [[nodiscard]] auto getBatchSize() const -> unsigned int;
     void setInput(unsigned int i, float real);
+    // frameSize contiguous input samples of one transform, for bulk writes
+    [[nodiscard]] auto getInputBuffer(unsigned int transform) -> float*;
     void execute();
+    void executeBatch(unsigned int transformCount);
     [[nodiscard]] auto getOutputReal(unsigned int i) const -> float;
     [[nodiscard]] auto getOutputImaginary(unsigned int i) const -> float;
     [[nodiscard]] auto getOutputMagnitude(unsigned int i) const -> float;
+    [[nodiscard]] auto getOutputMagnitude(unsigned int transform, unsigned int i) const -> float;
+    // Magnitudes of bins [first, first + count) of one transform, computed in a
+    // single pass into a buffer owned by the adapter. The pointer is valid
+    // until the next call.
+    [[nodiscard]] auto getOutputMagnitudes(unsigned int transform, unsigned int first, unsigned int count) const -> const float*;
 
 protected:
     unsigned int frameSize;
+    unsigned int batchSize;
     FftAdapterPrivate* priv;
 };
 
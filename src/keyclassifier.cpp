@@ -21,11 +21,14 @@
 
 #include "keyclassifier.h"
 
+#include "vectorops.h"
+
 #include <math.h>
 
 namespace KeyFinder {
 
 KeyClassifier::KeyClassifier(const std::vector<float>& majorProfile, const std::vector<float>& minorProfile)
+    : keyProfiles_((size_t)SEMITONES * 2 * BANDS, 0.0)
 {
 
     if (majorProfile.size() != BANDS) {
@@ -36,37 +39,86 @@ KeyClassifier::KeyClassifier(const std::vector<float>& majorProfile, const std::
         throw Exception("Tone profile must have 72 elements");
     }
 
-    major_ = new ToneProfile(majorProfile);
-    minor_ = new ToneProfile(minorProfile);
-    silence_ = new ToneProfile(std::vector<float>(BANDS, 0.0));
+    setProfile(majorProfile, 0);
+    setProfile(minorProfile, 1);
 }
 
-KeyClassifier::~KeyClassifier()
+// Fills the rows of the keys firstKey, firstKey + 2, ... with the profile
+// rotated up a semitone at a time. Profiles start on A and chroma vectors on
+// A, so the unrotated profile is offset by 3 semitones to put the tonic on C.
+void KeyClassifier::setProfile(const std::vector<float>& profile, unsigned int firstKey)
 {
-    delete major_;
-    delete minor_;
-    delete silence_;
+    float norm = sqrt(dotProduct(profile.data(), profile.data(), BANDS));
+    if (norm <= 0) {
+        // a silent profile never matches anything
+        return;
+    }
+    for (unsigned int offset = 0; offset < SEMITONES; offset++) {
+        float* row = keyProfiles_.data() + ((size_t)(firstKey + offset * 2) * BANDS);
+        for (unsigned int o = 0; o < OCTAVES; o++) {
+            for (unsigned int i = 0; i < SEMITONES; i++) {
+                unsigned int semitone = (i + 3 + SEMITONES - offset) % SEMITONES;
+                row[o * SEMITONES + i] = profile[o * SEMITONES + semitone] / norm;
+            }
+        }
+    }
 }
 
-auto KeyClassifier::classify(const std::vector<float>& chromaVector) -> KeyT
+auto KeyClassifier::classify(const std::vector<float>& chromaVector) const -> KeyT
 {
-    std::vector<float> scores(24);
-    float bestScore = 0.0;
-    for (unsigned int i = 0; i < SEMITONES; i++) {
-        float score = NAN;
-        score = major_->cosineSimilarity(chromaVector, i); // major
-        scores[i * 2] = score;
-        score = minor_->cosineSimilarity(chromaVector, i); // minor
-        scores[(i * 2) + 1] = score;
+    if (chromaVector.size() != BANDS) {
+        throw Exception("Chroma data must have 72 elements");
+    }
+    return classify(chromaVector.data());
+}
+
+auto KeyClassifier::classify(const float* chromaVector) const -> KeyT
+{
+    return scoreKeys(chromaVector, nullptr);
+}
+
+auto KeyClassifier::estimate(const std::vector<float>& chromaVector) const -> KeyEstimate
+{
+    if (chromaVector.size() != BANDS) {
+        throw Exception("Chroma data must have 72 elements");
     }
-    bestScore = silence_->cosineSimilarity(chromaVector, 0);
+    return estimate(chromaVector.data());
+}
+
+auto KeyClassifier::estimate(const float* chromaVector) const -> KeyEstimate
+{
+    KeyEstimate result;
+    scoreKeys(chromaVector, &result);
+    return result;
+}
+
+auto KeyClassifier::scoreKeys(const float* chromaVector, KeyEstimate* estimate) const -> KeyT
+{
+    float inputNorm = sqrt(dotProduct(chromaVector, chromaVector, BANDS));
     // find best match, defaulting to silence
     KeyT bestMatch = SILENCE;
-    for (unsigned int i = 0; i < 24; i++) {
-        if (scores[i] > bestScore) {
-            bestScore = scores[i];
-            bestMatch = (KeyT)i;
+    if (!(inputNorm > 0)) {
+        return bestMatch;
+    }
+    float bestScore = 0.0;
+    float secondScore = 0.0;
+    for (unsigned int k = 0; k < SEMITONES * 2; k++) {
+        float score = dotProduct(keyProfiles_.data() + ((size_t)k * BANDS), chromaVector, BANDS) / inputNorm;
+        if (estimate != nullptr) {
+            estimate->scores[k] = score;
         }
+        if (score > bestScore) {
+            secondScore = bestScore;
+            bestScore = score;
+            bestMatch = (KeyT)k;
+        } else if (score > secondScore) {
+            secondScore = score;
+        }
+    }
+    if (estimate != nullptr) {
+        estimate->key = bestMatch;
+        estimate->margin = bestScore - secondScore;
+        estimate->confidence = bestScore > 0 ? estimate->margin / bestScore : 0.0;
     }
     return bestMatch;
 }
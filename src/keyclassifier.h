@@ -27,16 +27,35 @@
 
 namespace KeyFinder {
 
+// The best matching key, and the cosine similarity of the chroma vector to
+// each key's profile, indexed by KeyT. Silence scores zero throughout.
+struct KeyEstimate {
+    KeyT key { SILENCE };
+    std::vector<float> scores = std::vector<float>(KEYS, 0.0);
+    // the leading score less the runner-up's
+    float margin { 0.0 };
+    // margin as a fraction of the leading score, from 0 for a tie to 1 when
+    // no other key matches at all
+    float confidence { 0.0 };
+};
+
+// Scores chroma vectors against every rotation of a major and a minor tone
+// profile. The rotations are normalised once on construction, so each
+// classification is a single 24 x BANDS matrix-vector product.
 class KeyClassifier {
 public:
     KeyClassifier(const std::vector<float>& majorProfile, const std::vector<float>& minorProfile);
-    ~KeyClassifier();
-    auto classify(const std::vector<float>& chromaVector) -> KeyT;
+    [[nodiscard]] auto classify(const std::vector<float>& chromaVector) const -> KeyT;
+    [[nodiscard]] auto classify(const float* chromaVector) const -> KeyT;
+    [[nodiscard]] auto estimate(const std::vector<float>& chromaVector) const -> KeyEstimate;
+    [[nodiscard]] auto estimate(const float* chromaVector) const -> KeyEstimate;
 
 private:
-    ToneProfile* major_;
-    ToneProfile* minor_;
-    ToneProfile* silence_;
+    // fills in the estimate if given, and returns the best match
+    auto scoreKeys(const float* chromaVector, KeyEstimate* estimate) const -> KeyT;
+    void setProfile(const std::vector<float>& profile, unsigned int firstKey);
+    // row k holds the profile of key k, scaled to unit length
+    std::vector<float> keyProfiles_;
 };
 
 }
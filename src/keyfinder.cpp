@@ -20,77 +20,534 @@
 *************************************************************************/
 
 #include "keyfinder.h"
+#include "snapshotcache.h"
+#include "workstealingpool.h"
+
+#include <climits>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 namespace KeyFinder {
 
+static auto resolveThreadCount(unsigned int threadCount) -> unsigned int
+{
+    if (threadCount == 0) {
+        return std::max(1U, std::thread::hardware_concurrency());
+    }
+    return threadCount;
+}
+
+// order of the anti-aliasing filter used when decimating
+static const unsigned int LPF_ORDER = 160;
+
+// Audio is decimated by this factor before spectral analysis.
+static auto downsampleFactorOf(unsigned int frameRate) -> unsigned int
+{
+    // TODO: there is presumably some good maths to determine filter frequencies. For now, this approximates original experiment values.
+    float dsCutoff = getLastFrequency() * 1.10;
+    return (int)floor(frameRate / 2 / dsCutoff);
+}
+
+// The default profiles are classified often enough to keep their classifier
+// for the lifetime of the library.
+static auto defaultKeyClassifier() -> const KeyClassifier&
+{
+    static const KeyClassifier classifier(toneProfileMajor(), toneProfileMinor());
+    return classifier;
+}
+
+KeyFinder::KeyFinder(const AnalysisConfig& config)
+    : config_(config)
+{
+    if (config.frameSize < 1 || config.hopSize < 1) {
+        throw Exception("Analysis frame and hop sizes must be > 0");
+    }
+    if (config.hopSize > config.frameSize) {
+        std::ostringstream ss;
+        ss << "Hop size (" << config.hopSize << ") cannot exceed frame size (" << config.frameSize << ")";
+        throw Exception(ss.str().c_str());
+    }
+    if (config.frameSize % 4 != 0) {
+        std::ostringstream ss;
+        ss << "Frame size (" << config.frameSize << ") must be a multiple of 4";
+        throw Exception(ss.str().c_str());
+    }
+    if (config.analysisRate != 0 && getLastFrequency() * 1.012 >= config.analysisRate / 2.0) {
+        std::ostringstream ss;
+        ss << "Analysis rate (" << config.analysisRate << ") is too low for frequencies up to " << getLastFrequency() << " Hz";
+        throw Exception(ss.str().c_str());
+    }
+    if (config.analysisRate != 0) {
+        // checks the low-end resolution, and warms the kernel for the first analysis
+        (void)ctFactory_.getChromaTransform(config.analysisRate, config.frameSize);
+    }
+}
+
+auto KeyFinder::getAnalysisConfig() const -> const AnalysisConfig&
+{
+    return config_;
+}
+
 auto KeyFinder::keyOfAudio(const AudioData& originalAudio) -> KeyT
 {
+    return keyOfAudio(AudioView(originalAudio.getSampleData(), originalAudio.getFrameCount(), originalAudio.getChannels(), originalAudio.getFrameRate()));
+}
+
+auto KeyFinder::keyOfAudio(const AudioView& originalAudio) -> KeyT
+{
+    // a warm workspace keeps its FFT plan and buffers from the previous track
+    Workspace* workspace = workspacePool_.acquire();
+    try {
+        progressiveChromagram(originalAudio, *workspace);
+        finalChromagram(*workspace);
+        KeyT key = keyOfChromaVector(workspace->chromagram->collapseToOneHop());
+        workspacePool_.release(workspace);
+        return key;
+    } catch (...) {
+        workspacePool_.release(workspace);
+        throw;
+    }
+}
+
+auto KeyFinder::keyOfAudioUntilStable(const AudioData& audio, const StabilityCriterion& criterion) -> StableKeyResult
+{
+    return keyOfAudioUntilStable(AudioView(audio.getSampleData(), audio.getFrameCount(), audio.getChannels(), audio.getFrameRate()), criterion);
+}
+
+// Feeds the audio to the progressive API a few hops at a time, tracking how
+// long the current leader has held on.
+auto KeyFinder::keyOfAudioUntilStable(const AudioView& audio, const StabilityCriterion& criterion) -> StableKeyResult
+{
+    unsigned int chunkFrames = inputFramesOf(config_.hopSize * std::max(1U, criterion.checkIntervalHops), audio.getFrameRate());
+
+    StableKeyResult result;
+    Workspace* workspace = workspacePool_.acquire();
+    try {
+        KeyT leader = SILENCE;
+        unsigned int leaderSince = 0;
+        while (result.framesAnalysed < audio.getFrameCount()) {
+            unsigned int frames = std::min(chunkFrames, audio.getFrameCount() - result.framesAnalysed);
+            progressiveChromagram(audio.subView(result.framesAnalysed, frames), *workspace);
+            result.framesAnalysed += frames;
+
+            unsigned int hops = workspace->chromagram == nullptr ? 0 : workspace->chromagram->getHops();
+            KeyEstimate estimate = keyEstimateOfChromagram(*workspace);
+            if (estimate.key != leader || estimate.key == SILENCE || estimate.margin < criterion.minimumMargin) {
+                leader = estimate.key;
+                leaderSince = hops;
+            } else if (hops - leaderSince >= criterion.stableHops) {
+                result.stoppedEarly = true;
+                break;
+            }
+        }
+        if (!result.stoppedEarly) {
+            finalChromagram(*workspace);
+        }
+        result.key = keyOfChromagram(*workspace);
+        result.hopsAnalysed = workspace->chromagram->getHops();
+        workspacePool_.release(workspace);
+        return result;
+    } catch (...) {
+        workspacePool_.release(workspace);
+        throw;
+    }
+}
+
+auto KeyFinder::keyOfAudioQuickScan(const AudioData& audio, const QuickScanOptions& options) -> QuickScanResult
+{
+    return keyOfAudioQuickScan(AudioView(audio.getSampleData(), audio.getFrameCount(), audio.getChannels(), audio.getFrameRate()), options);
+}
+
+// The sampled hops are analysed as one hop series with a longer hop. Where
+// their frames overlap, the audio they span is preprocessed as one excerpt;
+// otherwise each frame's audio is preprocessed on its own and the audio in
+// between is never read. Either way the excerpts are warmed up, so each
+// sampled hop's chroma is exactly what a full analysis finds there.
+auto KeyFinder::keyOfAudioQuickScan(const AudioView& audio, const QuickScanOptions& options) -> QuickScanResult
+{
+    unsigned int analysisLength = analysisSamplesOf(audio.getFrameCount(), audio.getFrameRate());
+    QuickScanResult result;
+    if (analysisLength >= config_.frameSize) {
+        result.hopsTotal = 1 + ((analysisLength - config_.frameSize) / config_.hopSize);
+    }
+    if (result.hopsTotal == 0) {
+        // too short to sample; analyse it all
+        result.key = keyOfAudio(audio);
+        result.hopsTotal = 1;
+        result.hopsAnalysed = 1;
+        return result;
+    }
+
+    unsigned int stride = std::max(1U, options.hopStride);
+    if (options.hopBudget > 0) {
+        stride = std::max(1U, (result.hopsTotal + options.hopBudget - 1) / options.hopBudget);
+    }
+    // centre the samples, since intros and outros are the least typical parts
+    unsigned int firstHop = ((result.hopsTotal - 1) % stride) / 2;
+    unsigned int sampledHops = 1 + ((result.hopsTotal - 1 - firstHop) / stride);
+    unsigned int sampleSpacing = stride * config_.hopSize;
+    // consecutive samples share an excerpt while their frames overlap
+    unsigned int hopsPerExcerpt = sampleSpacing < config_.frameSize ? sampledHops : 1;
+    // Separate samples are jittered within their stride, so that music which
+    // repeats every few hops isn't always caught at the same point of the
+    // repeat. The jitter is a fixed hash, so results are reproducible.
+    auto sampleHop = [&](unsigned int sample) -> unsigned int {
+        unsigned int hop = firstHop + (sample * stride);
+        if (hopsPerExcerpt > 1 || stride < 2) {
+            return hop;
+        }
+        unsigned int jitter = (((sample + 1) * 2654435761U) >> 16) % stride;
+        hop = (hop >= stride / 2 ? hop - (stride / 2) : 0) + jitter;
+        return std::min(hop, result.hopsTotal - 1);
+    };
+
+    SpectrumAnalyser sa(analysisRateOf(audio.getFrameRate()), &ctFactory_, &twFactory_, config_.frameSize, sampleSpacing);
+    Chromagram sampled;
+    Workspace* workspace = workspacePool_.acquire();
+    try {
+        for (unsigned int first = 0; first < sampledHops; first += hopsPerExcerpt) {
+            unsigned int hops = std::min(hopsPerExcerpt, sampledHops - first);
+            unsigned int excerptSamples = ((hops - 1) * sampleSpacing) + config_.frameSize;
+            preprocessSpan(audio, sampleHop(first) * config_.hopSize, excerptSamples, *workspace);
+            // padded as a full analysis would be, should the stream end early
+            AudioData& excerpt = workspace->preprocessedBuffer;
+            excerpt.addToSampleCount(excerptSamples - std::min(excerptSamples, excerpt.getSampleCount()));
+            prepareFftAdapter(*workspace);
+            Chromagram* c = sa.chromagramOfHops(workspace->preprocessedBuffer, workspace->fftAdapter, 0, hops, workspace->stats);
+            sampled.append(*c);
+            delete c;
+        }
+        workspacePool_.release(workspace);
+    } catch (...) {
+        workspacePool_.release(workspace);
+        throw;
+    }
+
+    float chromaVector[BANDS];
+    sampled.collapseToOneHop(chromaVector);
+    result.key = defaultKeyClassifier().classify(chromaVector);
+    result.hopsAnalysed = sampled.getHops();
+    return result;
+}
+
+auto KeyFinder::keyOfAudio(const AudioData& originalAudio, unsigned int threadCount) -> KeyT
+{
+    threadCount = resolveThreadCount(threadCount);
+    if (threadCount == 1) {
+        return keyOfAudio(originalAudio);
+    }
+
+    Workspace* workspace = workspacePool_.acquire();
+    try {
+        preprocessInParallel(AudioView(originalAudio.getSampleData(), originalAudio.getFrameCount(), originalAudio.getChannels(), originalAudio.getFrameRate()), *workspace, threadCount);
+        finishPreprocessing(*workspace);
+        chromagramOfBufferedAudio(*workspace, threadCount);
+        KeyT key = keyOfChromaVector(workspace->chromagram->collapseToOneHop());
+        workspacePool_.release(workspace);
+        return key;
+    } catch (...) {
+        workspacePool_.release(workspace);
+        throw;
+    }
+}
+
+auto KeyFinder::keyOfAudioBatch(const std::vector<const AudioData*>& tracks, unsigned int threadCount) -> std::vector<KeyT>
+{
+    std::vector<KeyT> keys(tracks.size(), SILENCE);
+    std::vector<std::exception_ptr> errors(tracks.size());
+    keyOfAudioBatch(tracks, [&keys, &errors](unsigned int index, KeyT key, std::exception_ptr error) {
+        keys[index] = key;
+        errors[index] = error;
+    }, threadCount);
+    for (auto& error : errors) {
+        if (error != nullptr) {
+            std::rethrow_exception(error);
+        }
+    }
+    return keys;
+}
+
+void KeyFinder::keyOfAudioBatch(const std::vector<const AudioData*>& tracks, const BatchCallback& onComplete, unsigned int threadCount)
+{
+    // a track's cost is roughly its sample count
+    std::vector<unsigned long long> costs(tracks.size(), 0);
+    for (unsigned int i = 0; i < tracks.size(); i++) {
+        if (tracks[i] != nullptr) {
+            costs[i] = tracks[i]->getSampleCount();
+        }
+    }
+    WorkStealingPool::run(costs, resolveThreadCount(threadCount), [this, &tracks, &onComplete](unsigned int index) {
+        KeyT key = SILENCE;
+        std::exception_ptr error;
+        try {
+            if (tracks[index] == nullptr) {
+                throw Exception("Cannot analyse a null track");
+            }
+            key = keyOfAudio(*tracks[index]);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        onComplete(index, key, error);
+    });
+}
 
-    Workspace workspace;
-    progressiveChromagram(originalAudio, workspace);
-    finalChromagram(workspace);
+void KeyFinder::keyOfAudioBatch(const TrackSource& source, const BatchCallback& onComplete, unsigned int threadCount)
+{
+    // tracks arrive one at a time with unknown lengths, so threads simply
+    // take the next one as they become free
+    std::mutex sourceMutex;
+    unsigned int nextIndex = 0;
+    bool stopped = false;
+    std::exception_ptr failure;
+    auto work = [&]() {
+        while (true) {
+            const AudioData* track = nullptr;
+            unsigned int index = 0;
+            {
+                std::lock_guard<std::mutex> lock(sourceMutex);
+                if (stopped) {
+                    return;
+                }
+                try {
+                    track = source();
+                } catch (...) {
+                    failure = std::current_exception();
+                    stopped = true;
+                    return;
+                }
+                if (track == nullptr) {
+                    stopped = true;
+                    return;
+                }
+                index = nextIndex++;
+            }
+            KeyT key = SILENCE;
+            std::exception_ptr error;
+            try {
+                key = keyOfAudio(*track);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            try {
+                onComplete(index, key, error);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(sourceMutex);
+                if (failure == nullptr) {
+                    failure = std::current_exception();
+                }
+                stopped = true;
+                return;
+            }
+        }
+    };
 
-    return keyOfChromaVector(workspace.chromagram->collapseToOneHop());
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < resolveThreadCount(threadCount); t++) {
+        try {
+            threads.emplace_back(work);
+        } catch (...) {
+            break;
+        }
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (failure != nullptr) {
+        std::rethrow_exception(failure);
+    }
 }
 
-void KeyFinder::progressiveChromagram(AudioData audio, Workspace& workspace)
+void KeyFinder::progressiveChromagram(const AudioData& audio, Workspace& workspace)
+{
+    progressiveChromagram(AudioView(audio.getSampleData(), audio.getFrameCount(), audio.getChannels(), audio.getFrameRate()), workspace);
+}
+
+void KeyFinder::progressiveChromagram(const AudioView& audio, Workspace& workspace)
 {
     preprocess(audio, workspace);
-    workspace.preprocessedBuffer.append(audio);
     chromagramOfBufferedAudio(workspace);
 }
 
 void KeyFinder::finalChromagram(Workspace& workspace)
 {
-    // flush remainder buffer
-    if (workspace.remainderBuffer.getSampleCount() > 0) {
-        AudioData flush;
+    finishPreprocessing(workspace);
+    chromagramOfBufferedAudio(workspace);
+}
+
+void KeyFinder::finishPreprocessing(Workspace& workspace)
+{
+    // flush the filter history in the remainder buffer
+    if (workspace.remainderBuffer.getSampleCount() > 0 || workspace.decimationPosition != 0 || workspace.resamplePosition != 0) {
+        AudioView flush(nullptr, 0, 1, workspace.remainderBuffer.getFrameRate());
         preprocess(flush, workspace, true);
     }
     // zero padding
-    unsigned int paddedHopCount = ceil(workspace.preprocessedBuffer.getSampleCount() / (float)HOPSIZE);
-    unsigned int finalSampleLength = FFTFRAMESIZE + ((paddedHopCount - 1) * HOPSIZE);
+    unsigned int paddedHopCount = ceil(workspace.preprocessedBuffer.getSampleCount() / (float)config_.hopSize);
+    unsigned int finalSampleLength = config_.frameSize + ((paddedHopCount - 1) * config_.hopSize);
     workspace.preprocessedBuffer.addToSampleCount(finalSampleLength - workspace.preprocessedBuffer.getSampleCount());
-    chromagramOfBufferedAudio(workspace);
 }
 
-void KeyFinder::preprocess(AudioData& workingAudio, Workspace& workspace, bool flushRemainderBuffer)
+// Downmixes, low pass filters and decimates (or resamples) the audio in a
+// single pass, appending the result to the workspace's preprocessed buffer.
+// The filter's unread history waits in the remainder buffer for the next call.
+void KeyFinder::preprocess(const AudioView& audio, Workspace& workspace, bool flushRemainderBuffer)
 {
+    StageTimer timer(workspace.stats, STAGE_PREPROCESS, audio.getFrameCount());
+    AudioData& remainder = workspace.remainderBuffer;
+    if (remainder.getSampleCount() > 0 && remainder.getFrameRate() != audio.getFrameRate()) {
+        throw Exception("Cannot prepend audio data with a different frame rate");
+    }
 
-    workingAudio.reduceToMono();
+    float lpfCutoff = getLastFrequency() * 1.012;
+    AudioData& preprocessed = workspace.preprocessedBuffer;
+    if (config_.analysisRate != 0) {
+        const Resampler* resampler = resamplerFactory_.getResampler(audio.getFrameRate(), config_.analysisRate, lpfCutoff);
+        resampler->resample(audio, preprocessed, workspace, flushRemainderBuffer);
+        return;
+    }
+    unsigned int downsampleFactor = downsampleFactorOf(audio.getFrameRate());
+    const LowPassFilter* lpf = lpfFactory_.getLowPassFilter(LPF_ORDER, audio.getFrameRate(), lpfCutoff, 2048);
+    lpf->decimate(audio, preprocessed, workspace, downsampleFactor, flushRemainderBuffer);
+    // note we don't delete the LPF; it's stored in the factory for reuse
+}
 
-    if (workspace.remainderBuffer.getChannels() > 0) {
-        workingAudio.prepend(workspace.remainderBuffer);
-        workspace.remainderBuffer.discardFramesFromFront(workspace.remainderBuffer.getFrameCount());
+// The preprocessed stream comes in blocks: a whole number of input frames
+// that yields a whole number of output samples, so a stream started on a
+// block boundary produces the same outputs as the whole stream from there on.
+auto KeyFinder::preprocessBlocksOf(unsigned int frameRate) -> PreprocessBlocks
+{
+    PreprocessBlocks blocks;
+    if (config_.analysisRate != 0) {
+        // an output reads the tapsPerPhase frames up to and including its newest
+        const Resampler* resampler = resamplerFactory_.getResampler(frameRate, config_.analysisRate, getLastFrequency() * 1.012);
+        blocks.blockFrames = resampler->getDownFactor();
+        blocks.blockSamples = resampler->getUpFactor();
+        blocks.warmUpFrames = resampler->getTapsPerPhase();
+        blocks.lookAheadFrames = 0;
+    } else {
+        // an output reads order / 2 frames either side of its centre
+        blocks.blockFrames = std::max(1U, downsampleFactorOf(frameRate));
+        blocks.blockSamples = 1;
+        blocks.warmUpFrames = LPF_ORDER / 2;
+        blocks.lookAheadFrames = (LPF_ORDER / 2) + 1;
     }
+    return blocks;
+}
 
-    // TODO: there is presumably some good maths to determine filter frequencies. For now, this approximates original experiment values.
-    float lpfCutoff = getLastFrequency() * 1.012;
-    float dsCutoff = getLastFrequency() * 1.10;
-    unsigned int downsampleFactor = (int)floor(workingAudio.getFrameRate() / 2 / dsCutoff);
+// The span is preprocessed as a stream of its own, starting on a block
+// boundary early enough to warm the filter up and reading on far enough for
+// its last outputs, so they are exactly those of the whole stream.
+void KeyFinder::preprocessSpan(const AudioView& audio, unsigned int firstSample, unsigned int sampleCount, Workspace& workspace)
+{
+    PreprocessBlocks blocks = preprocessBlocksOf(audio.getFrameRate());
+    unsigned long long warmUpBlocks = (blocks.warmUpFrames + blocks.blockFrames - 1) / blocks.blockFrames;
+    unsigned long long firstBlock = firstSample / blocks.blockSamples;
+    unsigned long long endBlock = ((unsigned long long)firstSample + sampleCount + blocks.blockSamples - 1) / blocks.blockSamples;
+    unsigned long long startBlock = firstBlock - std::min(firstBlock, warmUpBlocks);
+    unsigned long long startFrame = std::min<unsigned long long>(startBlock * blocks.blockFrames, audio.getFrameCount());
+    unsigned long long endFrame = std::min<unsigned long long>((endBlock * blocks.blockFrames) + blocks.lookAheadFrames, audio.getFrameCount());
 
-    unsigned int bufferExcess = workingAudio.getSampleCount() % downsampleFactor;
-    if (!flushRemainderBuffer && bufferExcess != 0) {
-        AudioData* remainder = workingAudio.sliceSamplesFromBack(bufferExcess);
-        workspace.remainderBuffer.append(*remainder);
-        delete remainder;
+    workspace.reset();
+    preprocess(audio.subView(startFrame, endFrame - startFrame), workspace, true);
+    AudioData& preprocessed = workspace.preprocessedBuffer;
+    preprocessed.discardFramesFromFront(std::min<unsigned long long>(firstSample - (startBlock * blocks.blockSamples), preprocessed.getSampleCount()));
+    if (preprocessed.getSampleCount() > sampleCount) {
+        preprocessed.discardFramesFromBack(preprocessed.getSampleCount() - sampleCount);
     }
+}
 
-    const LowPassFilter* lpf = lpfFactory_.getLowPassFilter(160, workingAudio.getFrameRate(), lpfCutoff, 2048);
-    lpf->filter(workingAudio, workspace, downsampleFactor);
-    // note we don't delete the LPF; it's stored in the factory for reuse
+// The input is split into spans of whole blocks, preprocessed separately and
+// stitched together.
+void KeyFinder::preprocessInParallel(const AudioView& audio, Workspace& workspace, unsigned int threadCount)
+{
+    StageTimer timer(workspace.stats, STAGE_PREPROCESS, audio.getFrameCount());
+    PreprocessBlocks blocks = preprocessBlocksOf(audio.getFrameRate());
+    unsigned int warmUpBlocks = (blocks.warmUpFrames + blocks.blockFrames - 1) / blocks.blockFrames;
+    unsigned int lookAheadBlocks = (blocks.lookAheadFrames + blocks.blockFrames - 1) / blocks.blockFrames;
+
+    // ranges much longer than the warm-up, so little is preprocessed twice
+    unsigned int blockCount = audio.getFrameCount() / blocks.blockFrames;
+    unsigned int minimumBlocks = 16 * std::max(1U, warmUpBlocks + lookAheadBlocks);
+    unsigned int rangeCount = std::min(threadCount, blockCount / minimumBlocks);
+    if (rangeCount < 2) {
+        preprocess(audio, workspace, true);
+        return;
+    }
+    unsigned int samplesPerRange = (blockCount / rangeCount) * blocks.blockSamples;
 
-    workingAudio.downsample(downsampleFactor);
+    std::vector<std::vector<float>> outputs(rangeCount);
+    std::vector<unsigned long long> costs(rangeCount, samplesPerRange);
+    WorkStealingPool::run(costs, threadCount, [&](unsigned int r) {
+        // the last range runs on to the end of the stream
+        unsigned int firstSample = r * samplesPerRange;
+        unsigned int sampleCount = r == rangeCount - 1 ? UINT_MAX - firstSample : samplesPerRange;
+        Workspace* rangeWorkspace = workspacePool_.acquire();
+        try {
+            preprocessSpan(audio, firstSample, sampleCount, *rangeWorkspace);
+            const AudioData& span = rangeWorkspace->preprocessedBuffer;
+            outputs[r].assign(span.getSampleData(), span.getSampleData() + span.getSampleCount());
+        } catch (...) {
+            workspacePool_.release(rangeWorkspace);
+            throw;
+        }
+        workspacePool_.release(rangeWorkspace);
+    });
+
+    AudioData& preprocessed = workspace.preprocessedBuffer;
+    if (preprocessed.getChannels() == 0 && preprocessed.getFrameRate() == 0) {
+        preprocessed.setChannels(1);
+        preprocessed.setFrameRate(analysisRateOf(audio.getFrameRate()));
+    }
+    for (const auto& output : outputs) {
+        unsigned int offset = preprocessed.getSampleCount();
+        preprocessed.addToSampleCount(output.size());
+        std::copy(output.begin(), output.end(), preprocessed.getSampleData() + offset);
+    }
 }
 
-void KeyFinder::chromagramOfBufferedAudio(Workspace& workspace)
+auto KeyFinder::analysisRateOf(unsigned int frameRate) const -> unsigned int
+{
+    if (config_.analysisRate != 0) {
+        return config_.analysisRate;
+    }
+    return frameRate / std::max(1U, downsampleFactorOf(frameRate));
+}
+
+auto KeyFinder::analysisSamplesOf(unsigned int frames, unsigned int frameRate) const -> unsigned int
 {
+    if (config_.analysisRate != 0) {
+        return (unsigned long long)frames * config_.analysisRate / frameRate;
+    }
+    return frames / std::max(1U, downsampleFactorOf(frameRate));
+}
+
+auto KeyFinder::inputFramesOf(unsigned int samples, unsigned int frameRate) const -> unsigned int
+{
+    if (config_.analysisRate != 0) {
+        return ((unsigned long long)samples * frameRate + config_.analysisRate - 1) / config_.analysisRate;
+    }
+    return samples * std::max(1U, downsampleFactorOf(frameRate));
+}
+
+void KeyFinder::prepareFftAdapter(Workspace& workspace) const
+{
+    if (workspace.fftAdapter != nullptr && workspace.fftAdapter->getFrameSize() != config_.frameSize) {
+        delete workspace.fftAdapter;
+        workspace.fftAdapter = nullptr;
+    }
     if (workspace.fftAdapter == nullptr) {
-        workspace.fftAdapter = new FftAdapter(FFTFRAMESIZE);
+        workspace.fftAdapter = new FftAdapter(config_.frameSize, FFTBATCHSIZE);
     }
-    SpectrumAnalyser sa(workspace.preprocessedBuffer.getFrameRate(), &ctFactory_, &twFactory_);
-    Chromagram* c = sa.chromagramOfWholeFrames(workspace.preprocessedBuffer, workspace.fftAdapter);
-    workspace.preprocessedBuffer.discardFramesFromFront(HOPSIZE * c->getHops());
+}
+
+void KeyFinder::chromagramOfBufferedAudio(Workspace& workspace)
+{
+    prepareFftAdapter(workspace);
+    SpectrumAnalyser sa(workspace.preprocessedBuffer.getFrameRate(), &ctFactory_, &twFactory_, config_.frameSize, config_.hopSize);
+    Chromagram* c = sa.chromagramOfWholeFrames(workspace.preprocessedBuffer, workspace.fftAdapter, workspace.stats);
+    workspace.preprocessedBuffer.discardFramesFromFront(config_.hopSize * c->getHops());
     if (workspace.chromagram == nullptr) {
         workspace.chromagram = c;
     } else {
@@ -99,22 +556,149 @@ void KeyFinder::chromagramOfBufferedAudio(Workspace& workspace)
     }
 }
 
+// Splits the whole hops of the buffered audio into contiguous ranges, one per
+// thread. Each helper thread borrows a pooled workspace for its FFT adapter;
+// the calling thread takes the first range using this workspace's adapter.
+void KeyFinder::chromagramOfBufferedAudio(Workspace& workspace, unsigned int threadCount)
+{
+    const AudioData& buffer = workspace.preprocessedBuffer;
+    if (threadCount < 2 || buffer.getSampleCount() < config_.frameSize) {
+        chromagramOfBufferedAudio(workspace);
+        return;
+    }
+
+    // ranges are whole FFT batches, so only the last range ends in a partial batch
+    unsigned int hops = 1 + ((buffer.getSampleCount() - config_.frameSize) / config_.hopSize);
+    unsigned int batches = (hops + FFTBATCHSIZE - 1) / FFTBATCHSIZE;
+    unsigned int rangeCount = std::min(threadCount, batches);
+    unsigned int hopsPerRange = ((batches + rangeCount - 1) / rangeCount) * FFTBATCHSIZE;
+    rangeCount = (hops + hopsPerRange - 1) / hopsPerRange;
+
+    SpectrumAnalyser sa(buffer.getFrameRate(), &ctFactory_, &twFactory_, config_.frameSize, config_.hopSize);
+    std::vector<Chromagram*> ranges(rangeCount, nullptr);
+    std::vector<std::exception_ptr> errors(rangeCount);
+    auto analyseRange = [&](unsigned int r, Workspace& rangeWorkspace) {
+        try {
+            prepareFftAdapter(rangeWorkspace);
+            unsigned int firstHop = r * hopsPerRange;
+            ranges[r] = sa.chromagramOfHops(buffer, rangeWorkspace.fftAdapter, firstHop, std::min(hopsPerRange, hops - firstHop), workspace.stats);
+        } catch (...) {
+            errors[r] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int r = 1; r < rangeCount; r++) {
+        try {
+            threads.emplace_back([this, &analyseRange, &errors, r]() {
+                Workspace* rangeWorkspace = nullptr;
+                try {
+                    rangeWorkspace = workspacePool_.acquire();
+                } catch (...) {
+                    errors[r] = std::current_exception();
+                    return;
+                }
+                analyseRange(r, *rangeWorkspace);
+                workspacePool_.release(rangeWorkspace);
+            });
+        } catch (...) {
+            errors[r] = std::current_exception();
+            break;
+        }
+    }
+    analyseRange(0, workspace);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // a range is only missing if it, or an earlier one, failed
+    for (unsigned int r = 0; r < rangeCount; r++) {
+        if (errors[r] != nullptr) {
+            for (auto* range : ranges) {
+                delete range;
+            }
+            std::rethrow_exception(errors[r]);
+        }
+    }
+    if (workspace.chromagram == nullptr) {
+        workspace.chromagram = new Chromagram(0);
+    }
+    for (auto* range : ranges) {
+        workspace.chromagram->append(*range);
+        delete range;
+    }
+
+    workspace.preprocessedBuffer.discardFramesFromFront(config_.hopSize * hops);
+}
+
 auto KeyFinder::keyOfChromaVector(const std::vector<float>& chromaVector) -> KeyT
 {
-    KeyClassifier classifier(toneProfileMajor(), toneProfileMinor());
-    return classifier.classify(chromaVector);
+    return defaultKeyClassifier().classify(chromaVector);
+}
+
+// A classifier built for one pair of override profiles.
+struct OverrideKeyClassifier {
+    OverrideKeyClassifier(const std::vector<float>& inMajor, const std::vector<float>& inMinor)
+        : major(inMajor)
+        , minor(inMinor)
+        , classifier(inMajor, inMinor)
+    {
+    }
+    std::vector<float> major;
+    std::vector<float> minor;
+    KeyClassifier classifier;
+};
+
+// Experiments classify many vectors against a few profile sets, often in
+// turn, so every set keeps its classifier for the lifetime of the library.
+static auto overrideKeyClassifier(const std::vector<float>& overrideMajorProfile, const std::vector<float>& overrideMinorProfile) -> const KeyClassifier&
+{
+    static SnapshotCache<OverrideKeyClassifier> classifiers;
+    return classifiers.find([&](const OverrideKeyClassifier& entry) { return entry.major == overrideMajorProfile && entry.minor == overrideMinorProfile; },
+        [&]() { return new OverrideKeyClassifier(overrideMajorProfile, overrideMinorProfile); })
+        ->classifier;
 }
 
 auto KeyFinder::keyOfChromaVector(const std::vector<float>& chromaVector, const std::vector<float>& overrideMajorProfile, const std::vector<float>& overrideMinorProfile) -> KeyT
 {
-    KeyClassifier classifier(overrideMajorProfile, overrideMinorProfile);
-    return classifier.classify(chromaVector);
+    return overrideKeyClassifier(overrideMajorProfile, overrideMinorProfile).classify(chromaVector);
+}
+
+auto KeyFinder::keyEstimateOfChromaVector(const std::vector<float>& chromaVector) -> KeyEstimate
+{
+    return defaultKeyClassifier().estimate(chromaVector);
+}
+
+auto KeyFinder::keyEstimateOfChromaVector(const std::vector<float>& chromaVector, const std::vector<float>& overrideMajorProfile, const std::vector<float>& overrideMinorProfile) -> KeyEstimate
+{
+    return overrideKeyClassifier(overrideMajorProfile, overrideMinorProfile).estimate(chromaVector);
 }
 
 auto KeyFinder::keyOfChromagram(const Workspace& workspace) -> KeyT
 {
-    KeyClassifier classifier(toneProfileMajor(), toneProfileMinor());
-    return classifier.classify(workspace.chromagram->collapseToOneHop());
+    StageTimer timer(workspace.stats, STAGE_CLASSIFICATION, 1);
+    float chromaVector[BANDS];
+    workspace.chromagram->collapseToOneHop(chromaVector);
+    return defaultKeyClassifier().classify(chromaVector);
+}
+
+auto KeyFinder::keyEstimateOfChromagram(const Workspace& workspace) -> KeyEstimate
+{
+    if (workspace.chromagram == nullptr) {
+        return KeyEstimate();
+    }
+    StageTimer timer(workspace.stats, STAGE_CLASSIFICATION, 1);
+    float chromaVector[BANDS];
+    workspace.chromagram->collapseToOneHop(chromaVector);
+    return defaultKeyClassifier().estimate(chromaVector);
+}
+
+auto KeyFinder::keySegmentsOfChromagram(const Workspace& workspace, unsigned int windowHops, unsigned int strideHops) -> KeySegmentation
+{
+    if (workspace.chromagram == nullptr) {
+        return segmentKeys(Chromagram(0), defaultKeyClassifier(), windowHops, strideHops);
+    }
+    return segmentKeys(*workspace.chromagram, defaultKeyClassifier(), windowHops, strideHops);
 }
 
 }
@@ -23,33 +23,177 @@
 #define KEYFINDER_H
 
 #include "audiodata.h"
+#include "audioview.h"
 #include "chromatransformfactory.h"
 #include "keyclassifier.h"
+#include "keysegmentation.h"
 #include "lowpassfilterfactory.h"
+#include "resamplerfactory.h"
 #include "spectrumanalyser.h"
+#include "workspacepool.h"
+
+#include <exception>
+#include <functional>
 
 namespace KeyFinder {
 
+// Sizes of the spectral analysis, in samples at the decimated frame rate.
+// Smaller frames cut latency and memory and longer hops cut work, at some
+// cost in accuracy. Frames must still resolve the lowest semitones, which
+// takes about 2700 samples at the usual 4410 Hz; sizes of 4096, 8192, 16384
+// and 32768 have specialised code paths. Frame sizes must be multiples of 4,
+// which keeps every frame of an FFT batch aligned.
+//
+// By default audio is decimated by a whole factor, so the analysis rate (and
+// with it the chroma kernel) depends on the source rate. A non-zero
+// analysisRate resamples every source to that one rate instead, so one kernel
+// serves all sources and results no longer depend on the source rate;
+// 4410 Hz matches what 44.1 kHz sources get by default. The resampler keeps
+// its transition band fixed in Hz, so its filter grows with the source rate:
+// at 96 kHz it has 351 taps per output to decimation's 161, and whole-track
+// analysis takes about half as long again (see the benchmark).
+struct AnalysisConfig {
+    unsigned int frameSize { FFTFRAMESIZE };
+    unsigned int hopSize { HOPSIZE };
+    unsigned int analysisRate { 0 };
+};
+
+// Stopping rule for KeyFinder::keyOfAudioUntilStable. Analysis ends once the
+// same key has led, ahead of the runner-up by at least minimumMargin in
+// cosine similarity, for stableHops hops. Stability is checked every
+// checkIntervalHops hops.
+struct StabilityCriterion {
+    unsigned int stableHops { 48 };
+    float minimumMargin { 0.005 };
+    unsigned int checkIntervalHops { FFTBATCHSIZE };
+};
+
+struct StableKeyResult {
+    KeyT key { SILENCE };
+    // how much of the audio was analysed before stopping
+    unsigned int framesAnalysed { 0 };
+    unsigned int hopsAnalysed { 0 };
+    bool stoppedEarly { false };
+};
+
+// Sampling for KeyFinder::keyOfAudioQuickScan: chroma for every hopStride-th
+// hop or, if hopBudget is set, for about hopBudget hops spread evenly over
+// the audio. Samples whose frames don't overlap are jittered within their
+// stride. Only the audio under the sampled frames is preprocessed, so the
+// cost follows the share of the audio they cover: every frame is read until
+// the stride passes 4 hops, and the default reads about a quarter of it.
+struct QuickScanOptions {
+    unsigned int hopStride { 16 };
+    unsigned int hopBudget { 0 };
+};
+
+struct QuickScanResult {
+    KeyT key { SILENCE };
+    unsigned int hopsAnalysed { 0 };
+    // the hops a full analysis would have covered
+    unsigned int hopsTotal { 0 };
+};
+
 class KeyFinder {
 public:
+    KeyFinder() = default;
+    // Throws if the hop is empty or longer than the frame, if the frame size
+    // isn't a multiple of 4, or if the analysis rate is too low for the
+    // highest analysed frequency. With an analysis rate, a frame too short for
+    // the lowest semitones is rejected here too; otherwise the frame rate
+    // isn't known until audio arrives, and the first analysis throws. A
+    // workspace
+    // should only be analysed by KeyFinders of one configuration.
+    explicit KeyFinder(const AnalysisConfig& config);
+    [[nodiscard]] auto getAnalysisConfig() const -> const AnalysisConfig&;
+
     // for progressive analysis
-    void progressiveChromagram(AudioData audio, Workspace& workspace);
+    void progressiveChromagram(const AudioData& audio, Workspace& workspace);
+    void progressiveChromagram(const AudioView& audio, Workspace& workspace);
     void finalChromagram(Workspace& workspace);
     [[nodiscard]] static auto keyOfChromagram(const Workspace& workspace) -> KeyT;
+    // The current key and the scores of every key. Takes constant time
+    // however long the chromagram, so it can be polled after every
+    // progressiveChromagram call. Silence if nothing has been analysed yet.
+    [[nodiscard]] static auto keyEstimateOfChromagram(const Workspace& workspace) -> KeyEstimate;
+    // Key per window of hops and the key changes between them; see
+    // segmentKeys. Hop h starts h * getAnalysisConfig().hopSize /
+    // preprocessedBuffer.getFrameRate() seconds into the audio.
+    [[nodiscard]] static auto keySegmentsOfChromagram(const Workspace& workspace, unsigned int windowHops, unsigned int strideHops) -> KeySegmentation;
 
     // for analysis of a whole audio file
     auto keyOfAudio(const AudioData& audio) -> KeyT;
+    auto keyOfAudio(const AudioView& audio) -> KeyT;
+    // as above, but spreading preprocessing and spectral analysis over
+    // threadCount threads (0 for one per hardware thread); the preprocessed
+    // audio and the chromagram are stitched back together in order, so the
+    // result is exactly keyOfAudio's
+    auto keyOfAudio(const AudioData& audio, unsigned int threadCount) -> KeyT;
+    // as keyOfAudio, but stopping as soon as the estimate meets the criterion;
+    // silence never counts as stable. Preprocessing doesn't depend on how the
+    // audio is chunked, so without early stopping the chromagram, and so the
+    // key, is the same as keyOfAudio's.
+    auto keyOfAudioUntilStable(const AudioData& audio, const StabilityCriterion& criterion = StabilityCriterion()) -> StableKeyResult;
+    auto keyOfAudioUntilStable(const AudioView& audio, const StabilityCriterion& criterion = StabilityCriterion()) -> StableKeyResult;
+    // a cheaper, rougher keyOfAudio for previews: only the audio under the
+    // sampled hops is preprocessed and transformed
+    auto keyOfAudioQuickScan(const AudioData& audio, const QuickScanOptions& options = QuickScanOptions()) -> QuickScanResult;
+    auto keyOfAudioQuickScan(const AudioView& audio, const QuickScanOptions& options = QuickScanOptions()) -> QuickScanResult;
+
+    // for analysis of many audio files at once, on threadCount threads (0 for
+    // one per hardware thread). Each track is analysed as by keyOfAudio.
+    // Called on the analysing thread as each track finishes; if the track
+    // couldn't be analysed, error holds the exception and key is SILENCE.
+    using BatchCallback = std::function<void(unsigned int index, KeyT key, std::exception_ptr error)>;
+    // Supplies tracks one at a time, returning nullptr when there are no more.
+    // Never called concurrently; the track must stay valid until its callback.
+    using TrackSource = std::function<const AudioData*()>;
+    // Keys in the order of tracks; rethrows the first track's error, if any,
+    // once the whole batch has finished.
+    auto keyOfAudioBatch(const std::vector<const AudioData*>& tracks, unsigned int threadCount = 0) -> std::vector<KeyT>;
+    void keyOfAudioBatch(const std::vector<const AudioData*>& tracks, const BatchCallback& onComplete, unsigned int threadCount = 0);
+    // Tracks are numbered in the order the source supplies them. Exceptions
+    // from the source or the callback stop the batch and are rethrown.
+    void keyOfAudioBatch(const TrackSource& source, const BatchCallback& onComplete, unsigned int threadCount = 0);
 
     // for experimentation with alternative tone profiles
     [[nodiscard]] static auto keyOfChromaVector(const std::vector<float>& chromaVector, const std::vector<float>& overrideMajorProfile, const std::vector<float>& overrideMinorProfile) -> KeyT;
+    // the key with every key's score, the winning margin and a confidence
+    [[nodiscard]] static auto keyEstimateOfChromaVector(const std::vector<float>& chromaVector) -> KeyEstimate;
+    [[nodiscard]] static auto keyEstimateOfChromaVector(const std::vector<float>& chromaVector, const std::vector<float>& overrideMajorProfile, const std::vector<float>& overrideMinorProfile) -> KeyEstimate;
 
 private:
-    void preprocess(AudioData& workingAudio, Workspace& workspace, bool flushRemainderBuffer = false);
+    void preprocess(const AudioView& audio, Workspace& workspace, bool flushRemainderBuffer = false);
+    // blockFrames input frames yield blockSamples preprocessed samples, which
+    // read warmUpFrames before the block and lookAheadFrames after it
+    struct PreprocessBlocks {
+        unsigned int blockFrames { 1 };
+        unsigned int blockSamples { 1 };
+        unsigned int warmUpFrames { 0 };
+        unsigned int lookAheadFrames { 0 };
+    };
+    auto preprocessBlocksOf(unsigned int frameRate) -> PreprocessBlocks;
+    // leaves samples [firstSample, firstSample + sampleCount) of the whole
+    // preprocessed stream in the reset workspace, reading only the audio they need
+    void preprocessSpan(const AudioView& audio, unsigned int firstSample, unsigned int sampleCount, Workspace& workspace);
+    // preprocess(audio, workspace, true), split over threadCount threads
+    void preprocessInParallel(const AudioView& audio, Workspace& workspace, unsigned int threadCount);
+    void finishPreprocessing(Workspace& workspace);
     void chromagramOfBufferedAudio(Workspace& workspace);
+    void chromagramOfBufferedAudio(Workspace& workspace, unsigned int threadCount);
+    void prepareFftAdapter(Workspace& workspace) const;
+    // conversions between source frames and preprocessed samples
+    [[nodiscard]] auto analysisRateOf(unsigned int frameRate) const -> unsigned int;
+    [[nodiscard]] auto analysisSamplesOf(unsigned int frames, unsigned int frameRate) const -> unsigned int;
+    [[nodiscard]] auto inputFramesOf(unsigned int samples, unsigned int frameRate) const -> unsigned int;
+    AnalysisConfig config_;
     [[nodiscard]] static auto keyOfChromaVector(const std::vector<float>& chromaVector) -> KeyT;
     LowPassFilterFactory lpfFactory_;
+    ResamplerFactory resamplerFactory_;
     ChromaTransformFactory ctFactory_;
     TemporalWindowFactory twFactory_;
+    // workspaces for whole-track analysis, kept warm between calls
+    WorkspacePool workspacePool_;
 };
 
 }
@@ -0,0 +1,102 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "keysegmentation.h"
+
+namespace KeyFinder {
+
+auto segmentKeys(const Chromagram& chromagram, const KeyClassifier& classifier, unsigned int windowHops, unsigned int strideHops) -> KeySegmentation
+{
+    if (windowHops == 0 || strideHops == 0) {
+        throw Exception("Key segmentation needs a window and stride of at least one hop");
+    }
+    unsigned int hops = chromagram.getHops();
+    if (chromagram.getFirstRetainedHop() > 0) {
+        std::ostringstream ss;
+        ss << "Cannot segment a chromagram whose first " << chromagram.getFirstRetainedHop() << " hops were discarded";
+        throw Exception(ss.str().c_str());
+    }
+
+    KeySegmentation result;
+    if (hops == 0) {
+        return result;
+    }
+
+    // row h holds the band totals of hops [0, h)
+    std::vector<double> prefixSums((size_t)(hops + 1) * BANDS, 0.0);
+    for (unsigned int h = 0; h < hops; h++) {
+        const float* hop = chromagram.getHop(h);
+        const double* previous = prefixSums.data() + ((size_t)h * BANDS);
+        double* current = prefixSums.data() + ((size_t)(h + 1) * BANDS);
+        for (unsigned int b = 0; b < BANDS; b++) {
+            current[b] = previous[b] + hop[b];
+        }
+    }
+
+    std::vector<unsigned int> starts;
+    if (hops <= windowHops) {
+        windowHops = hops;
+        starts.push_back(0);
+    } else {
+        for (unsigned int first = 0; first <= hops - windowHops; first += strideHops) {
+            starts.push_back(first);
+        }
+        if (starts.back() + windowHops < hops) {
+            starts.push_back(hops - windowHops);
+        }
+    }
+
+    // the classifier's cosine similarity ignores scale, so sums do as well as means
+    float windowChroma[BANDS];
+    for (unsigned int first : starts) {
+        const double* before = prefixSums.data() + ((size_t)first * BANDS);
+        const double* after = prefixSums.data() + ((size_t)(first + windowHops) * BANDS);
+        for (unsigned int b = 0; b < BANDS; b++) {
+            windowChroma[b] = after[b] - before[b];
+        }
+        KeySegment window;
+        window.firstHop = first;
+        window.hopCount = windowHops;
+        window.key = classifier.classify(windowChroma);
+        result.windows.push_back(window);
+    }
+
+    KeySegment segment = result.windows.front();
+    segment.firstHop = 0;
+    for (unsigned int w = 1; w < result.windows.size(); w++) {
+        const KeySegment& previous = result.windows[w - 1];
+        const KeySegment& window = result.windows[w];
+        if (window.key == segment.key) {
+            continue;
+        }
+        // halfway between the window centres
+        unsigned int boundary = (previous.firstHop + window.firstHop + windowHops) / 2;
+        segment.hopCount = boundary - segment.firstHop;
+        result.segments.push_back(segment);
+        segment.firstHop = boundary;
+        segment.key = window.key;
+    }
+    segment.hopCount = hops - segment.firstHop;
+    result.segments.push_back(segment);
+    return result;
+}
+
+}
@@ -0,0 +1,56 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef KEYSEGMENTATION_H
+#define KEYSEGMENTATION_H
+
+#include "chromagram.h"
+#include "constants.h"
+#include "keyclassifier.h"
+
+namespace KeyFinder {
+
+// A run of hops [firstHop, firstHop + hopCount) and its key.
+struct KeySegment {
+    unsigned int firstHop { 0 };
+    unsigned int hopCount { 0 };
+    KeyT key { SILENCE };
+};
+
+struct KeySegmentation {
+    // the key of each window, in order
+    std::vector<KeySegment> windows;
+    // consecutive windows of the same key merged; these tile the whole
+    // chromagram, and each one after the first starts at a key change
+    std::vector<KeySegment> segments;
+};
+
+// Classifies windows of windowHops hops, one starting every strideHops hops,
+// with a final window aligned to the end of the chromagram so no hops are
+// left over. A chromagram shorter than a window is classified as a whole.
+// Window sums come from prefix sums over the chromagram, so the cost doesn't
+// depend on the window length. A boundary between windows of different keys
+// is placed halfway between their centres. Every hop must still be retained.
+auto segmentKeys(const Chromagram& chromagram, const KeyClassifier& classifier, unsigned int windowHops, unsigned int strideHops) -> KeySegmentation;
+
+}
+
+#endif
@@ -28,10 +28,12 @@
 
 #include "lowpassfilter.h"
 
+#include <algorithm>
 #include <math.h>
 
 // implementation specific
 #include "fftadapter.h"
+#include "vectorops.h"
 #include "windowfunctions.h"
 
 namespace KeyFinder {
@@ -40,11 +42,15 @@ class LowPassFilterPrivate {
 public:
     LowPassFilterPrivate(unsigned int order, unsigned int frameRate, float cornerFrequency, unsigned int fftFrameSize);
     void filter(AudioData& audio, Workspace& workspace, unsigned int shortcutFactor = 1) const;
+    void decimate(AudioData& audio, Workspace& workspace, unsigned int factor) const;
+    void decimate(const AudioView& input, AudioData& output, Workspace& workspace, unsigned int factor, bool flush) const;
+    auto padInput(const AudioData& audio, Workspace& workspace) const -> const float*;
     unsigned int order;
     unsigned int delay; // always order / 2
     unsigned int impulseLength; // always order + 1
     float gain;
     std::vector<float> coefficients;
+    std::vector<float> scaledCoefficients; // coefficients / gain
 };
 
 LowPassFilter::LowPassFilter(unsigned int order, unsigned int frameRate, float cornerFrequency, unsigned int fftFrameSize)
@@ -63,6 +69,16 @@ void LowPassFilter::filter(AudioData& audio, Workspace& workspace, unsigned int
     priv->filter(audio, workspace, shortcutFactor);
 }
 
+void LowPassFilter::decimate(AudioData& audio, Workspace& workspace, unsigned int factor) const
+{
+    priv->decimate(audio, workspace, factor);
+}
+
+void LowPassFilter::decimate(const AudioView& input, AudioData& output, Workspace& workspace, unsigned int factor, bool flush) const
+{
+    priv->decimate(input, output, workspace, factor, flush);
+}
+
 auto LowPassFilter::getCoefficients() const -> void const*
 {
     return &priv->coefficients;
@@ -111,77 +127,145 @@ LowPassFilterPrivate::LowPassFilterPrivate(unsigned int inOrder, unsigned int fr
         gain += coeff;
     }
 
+    scaledCoefficients.resize(impulseLength);
+    for (unsigned int i = 0; i < impulseLength; i++) {
+        scaledCoefficients[i] = coefficients[i] / gain;
+    }
+
     delete ifft;
 }
 
-void LowPassFilterPrivate::filter(AudioData& audio, Workspace& workspace, unsigned int shortcutFactor) const
+// Copies the audio into the workspace's delay buffer with order / 2 zeros on
+// either side, so that output sample n is the dot product of the coefficients
+// with the impulseLength buffered samples starting at n.
+auto LowPassFilterPrivate::padInput(const AudioData& audio, Workspace& workspace) const -> const float*
 {
-
     if (audio.getChannels() > 1) {
         throw Exception("Monophonic audio only");
     }
 
-    std::vector<float>* buffer = workspace.lpfBuffer;
-
-    if (buffer == nullptr) {
-        workspace.lpfBuffer = new std::vector<float>(impulseLength, 0.0);
-        buffer = workspace.lpfBuffer;
-    } else {
-        // clear delay buffer
-        auto bufferIterator = buffer->begin();
-        while (bufferIterator < buffer->end()) {
-            *bufferIterator = 0.0;
-            std::advance(bufferIterator, 1);
-        }
+    unsigned int sampleCount = audio.getSampleCount();
+    if (workspace.lpfBuffer == nullptr) {
+        workspace.lpfBuffer = new std::vector<float>();
     }
+    std::vector<float>& buffer = *workspace.lpfBuffer;
+    buffer.resize(sampleCount + order);
+    std::fill(buffer.begin(), buffer.begin() + delay, 0.0);
+    std::copy(audio.getSampleData(), audio.getSampleData() + sampleCount, buffer.begin() + delay);
+    std::fill(buffer.end() - delay, buffer.end(), 0.0);
+    return buffer.data();
+}
+
+void LowPassFilterPrivate::filter(AudioData& audio, Workspace& workspace, unsigned int shortcutFactor) const
+{
+    const float* padded = padInput(audio, workspace);
+    unsigned int sampleCount = audio.getSampleCount();
+    float* samples = audio.getSampleData();
 
-    auto bufferFront = buffer->begin();
-    std::vector<float>::iterator bufferBack;
-    std::vector<float>::iterator bufferTemp;
+    // if shortcut != 1, only do the maths for the useful samples (this is mathematically dodgy, but it's faster and it usually works)
+    for (unsigned int outSample = 0; outSample < sampleCount; outSample += shortcutFactor) {
+        samples[outSample] = dotProduct(scaledCoefficients.data(), padded + outSample, impulseLength);
+    }
+}
 
+void LowPassFilterPrivate::decimate(AudioData& audio, Workspace& workspace, unsigned int factor) const
+{
+    const float* padded = padInput(audio, workspace);
     unsigned int sampleCount = audio.getSampleCount();
-    audio.resetIterators();
-
-    float sum = NAN;
-    // for each frame (running off the end of the sample stream by delay)
-    for (unsigned int inSample = 0; inSample < sampleCount + delay; inSample++) {
-        // shuffle old samples along delay buffer
-        bufferBack = bufferFront;
-        std::advance(bufferFront, 1);
-        if (bufferFront == buffer->end()) {
-            bufferFront = buffer->begin();
-        }
+    unsigned int outputCount = (sampleCount + factor - 1) / factor;
+    float* samples = audio.getSampleData();
 
-        // load new sample into back of delay buffer
-        if (audio.readIteratorWithinUpperBound()) {
-            *bufferBack = audio.getSampleAtReadIterator() / gain;
-            audio.advanceReadIterator();
-        } else {
-            *bufferBack = 0.0; // zero pad once we're past the end of the file
-        }
-        // start doing the maths once the delay has passed
-        int outSample = (signed)inSample - (signed)delay;
-        if (outSample < 0) {
-            continue;
+    for (unsigned int outSample = 0; outSample < outputCount; outSample++) {
+        samples[outSample] = dotProduct(scaledCoefficients.data(), padded + (outSample * factor), impulseLength);
+    }
+
+    audio.discardFramesFromBack(sampleCount - outputCount);
+    audio.setFrameRate(audio.getFrameRate() / factor);
+}
+
+// The window holds the stream from order / 2 samples before the next output's
+// centre onwards, i.e. window[j] is stream sample position - delay + j, with
+// zeros standing in for the samples before the stream starts. Outputs are
+// computed while their last tap is in the window; the tail they leave unread
+// is slid to the front, so each stream sample is downmixed exactly once. The
+// stream samples of that tail and the position carry over in the workspace's
+// remainder buffer and decimationPosition, so the output doesn't depend on
+// how the stream is split into calls.
+void LowPassFilterPrivate::decimate(const AudioView& input, AudioData& output, Workspace& workspace, unsigned int factor, bool flush) const
+{
+    AudioData& history = workspace.remainderBuffer;
+    if (history.getSampleCount() > 0 && history.getFrameRate() != input.getFrameRate()) {
+        throw Exception("Cannot prepend audio data with a different frame rate");
+    }
+    unsigned long long position = workspace.decimationPosition;
+
+    unsigned int blockOutputs = std::max(1U, 4096 / factor);
+    unsigned int windowLength = (blockOutputs - 1) * factor + impulseLength;
+    if (workspace.lpfBuffer == nullptr) {
+        workspace.lpfBuffer = new std::vector<float>();
+    }
+    std::vector<float>& window = *workspace.lpfBuffer;
+    // room for the zeros which drain the filter on flush
+    window.resize(windowLength + impulseLength + factor);
+    float* windowSamples = window.data();
+
+    unsigned int leadingZeros = position < delay ? delay - position : 0;
+    std::fill(windowSamples, windowSamples + leadingZeros, 0.0);
+    std::copy(history.getSampleData(), history.getSampleData() + history.getSampleCount(), windowSamples + leadingZeros);
+    unsigned int filled = leadingZeros + history.getSampleCount();
+
+    if (output.getChannels() == 0 && output.getFrameRate() == 0) {
+        output.setChannels(1);
+        output.setFrameRate(input.getFrameRate() / factor);
+    }
+
+    unsigned int consumed = 0;
+    while (true) {
+        unsigned int count = std::min(windowLength - std::min(windowLength, filled), input.getFrameCount() - consumed);
+        input.downmix(consumed, count, windowSamples + filled);
+        consumed += count;
+        filled += count;
+
+        unsigned int outputs = filled >= impulseLength ? ((filled - impulseLength) / factor) + 1 : 0;
+        bool last = consumed == input.getFrameCount();
+        if (last && flush) {
+            // every output centred on a stream sample, reading zeros past the end
+            outputs = filled > delay ? (filled - delay + factor - 1) / factor : 0;
+            unsigned int needed = outputs > 0 ? ((outputs - 1) * factor) + impulseLength : 0;
+            if (needed > filled) {
+                std::fill(windowSamples + filled, windowSamples + needed, 0.0);
+                filled = needed;
+            }
         }
-        // and, if shortcut != 1, only do the maths for the useful samples (this is mathematically dodgy, but it's faster and it usually works)
-        if (outSample % shortcutFactor > 0) {
-            continue;
+
+        unsigned int outputOffset = output.getSampleCount();
+        output.addToSampleCount(outputs);
+        float* outputSamples = output.getSampleData() + outputOffset;
+        for (unsigned int i = 0; i < outputs; i++) {
+            outputSamples[i] = dotProduct(scaledCoefficients.data(), windowSamples + (i * factor), impulseLength);
         }
-        sum = 0.0;
-        bufferTemp = bufferFront;
-        auto coefficientIterator = coefficients.begin();
-        while (coefficientIterator < coefficients.end()) {
-            sum += *coefficientIterator * *bufferTemp;
-            std::advance(coefficientIterator, 1);
-            std::advance(bufferTemp, 1);
-            if (bufferTemp == buffer->end()) {
-                bufferTemp = buffer->begin();
-            }
+
+        unsigned int discard = std::min(outputs * factor, filled);
+        std::copy(windowSamples + discard, windowSamples + filled, windowSamples);
+        filled -= discard;
+        position += (unsigned long long)outputs * factor;
+        if (last) {
+            break;
         }
-        audio.setSampleAtWriteIterator(sum);
-        audio.advanceWriteIterator(shortcutFactor);
     }
+
+    history.clear();
+    history.setChannels(1);
+    history.setFrameRate(input.getFrameRate());
+    if (flush) {
+        workspace.decimationPosition = 0;
+        return;
+    }
+    // keep only stream samples; the leading zeros are implied by the position
+    unsigned int zeros = position < delay ? delay - position : 0;
+    history.addToSampleCount(filled - zeros);
+    std::copy(windowSamples + zeros, windowSamples + filled, history.getSampleData());
+    workspace.decimationPosition = position;
 }
 
 }
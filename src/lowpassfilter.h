@@ -23,6 +23,7 @@
 #define LOWPASSFILTER_H
 
 #include "audiodata.h"
+#include "audioview.h"
 #include "constants.h"
 #include "workspace.h"
 
@@ -35,6 +36,16 @@ public:
     LowPassFilter(unsigned int order, unsigned int frameRate, float cornerFrequency, unsigned int fftFrameSize);
     ~LowPassFilter();
     void filter(AudioData& audio, Workspace& workspace, unsigned int shortcutFactor = 1) const;
+    // Filters and keeps every factor-th sample in one step; only the retained
+    // outputs are computed. Equivalent to filter(audio, workspace, factor)
+    // followed by audio.downsample(factor).
+    void decimate(AudioData& audio, Workspace& workspace, unsigned int factor) const;
+    // Fused downmix, filter and decimate for streams. Each input frame is read
+    // once and the decimated stream is appended to output. The filter history
+    // carries over in the workspace between calls, so any split of a stream
+    // gives the same result as decimate() on the whole of it, once the last
+    // call flushes the filter.
+    void decimate(const AudioView& input, AudioData& output, Workspace& workspace, unsigned int factor, bool flush) const;
     [[nodiscard]] auto getCoefficients() const -> void const*; // for unit testing only
 protected:
     LowPassFilterPrivate* priv;
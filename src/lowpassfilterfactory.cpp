@@ -62,31 +62,14 @@ auto LowPassFilterFactory::LowPassFilterWrapper::getFftFrameSize() const -> unsi
     return fftFrameSize_;
 }
 
-LowPassFilterFactory::LowPassFilterFactory()
-    : lowPassFilters_(0)
-{
-}
-
-LowPassFilterFactory::~LowPassFilterFactory()
-{
-    for (auto& lowPassFilter : lowPassFilters_) {
-        delete lowPassFilter;
-    }
-}
-
 auto LowPassFilterFactory::getLowPassFilter(unsigned int inOrder, unsigned int inFrameRate, float inCornerFrequency, unsigned int inFftFrameSize) -> const LowPassFilter*
 {
-    for (auto* wrapper : lowPassFilters_) {
-        if (wrapper->getOrder() == inOrder && wrapper->getFrameRate() == inFrameRate && wrapper->getCornerFrequency() == inCornerFrequency && wrapper->getFftFrameSize() == inFftFrameSize) {
-            return wrapper->getLowPassFilter();
-        }
-    }
-    lowPassFilterFactoryMutex_.lock();
-    auto* lpf = new LowPassFilter(inOrder, inFrameRate, inCornerFrequency, inFftFrameSize);
-    lowPassFilters_.push_back(new LowPassFilterWrapper(inOrder, inFrameRate, inCornerFrequency, inFftFrameSize, lpf));
-    unsigned int newLowPassFilterIndex = lowPassFilters_.size() - 1;
-    lowPassFilterFactoryMutex_.unlock();
-    return lowPassFilters_[newLowPassFilterIndex]->getLowPassFilter();
+    return lowPassFilters_.find([&](const LowPassFilterWrapper& wrapper) {
+        return wrapper.getOrder() == inOrder && wrapper.getFrameRate() == inFrameRate && wrapper.getCornerFrequency() == inCornerFrequency && wrapper.getFftFrameSize() == inFftFrameSize;
+    }, [&]() {
+        auto* lpf = new LowPassFilter(inOrder, inFrameRate, inCornerFrequency, inFftFrameSize);
+        return new LowPassFilterWrapper(inOrder, inFrameRate, inCornerFrequency, inFftFrameSize, lpf);
+    })->getLowPassFilter();
 }
 
 }
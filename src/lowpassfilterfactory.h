@@ -24,19 +24,17 @@
 
 #include "constants.h"
 #include "lowpassfilter.h"
+#include "snapshotcache.h"
 
 namespace KeyFinder {
 
 class LowPassFilterFactory {
 public:
-    LowPassFilterFactory();
-    ~LowPassFilterFactory();
     auto getLowPassFilter(unsigned int order, unsigned int frameRate, float cornerFrequency, unsigned int fftFrameSize) -> const LowPassFilter*;
 
 private:
     class LowPassFilterWrapper;
-    std::vector<LowPassFilterWrapper*> lowPassFilters_;
-    std::mutex lowPassFilterFactoryMutex_;
+    SnapshotCache<LowPassFilterWrapper> lowPassFilters_;
 };
 
 class LowPassFilterFactory::LowPassFilterWrapper {
@@ -0,0 +1,202 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "resampler.h"
+
+#include "vectorops.h"
+#include "windowfunctions.h"
+
+#include <algorithm>
+#include <math.h>
+#include <numeric>
+
+namespace KeyFinder {
+
+// input frames downmixed into the filter window at a time
+static const unsigned int RESAMPLER_BLOCK_FRAMES = 4096;
+// keeps the coefficient table within a few megabytes
+static const unsigned int MAX_RESAMPLER_PHASES = 4096;
+
+Resampler::Resampler(unsigned int inputRate, unsigned int outputRate, float cornerFrequency)
+    : inputRate_(inputRate)
+    , outputRate_(outputRate)
+{
+    if (inputRate < 1 || outputRate < 1) {
+        throw Exception("Frame rate must be > 0");
+    }
+    if (cornerFrequency >= inputRate / 2.0 || cornerFrequency >= outputRate / 2.0) {
+        throw Exception("Resampler corner frequency must be below Nyquist");
+    }
+    unsigned int divisor = std::gcd(inputRate, outputRate);
+    upFactor_ = outputRate / divisor;
+    downFactor_ = inputRate / divisor;
+    if (upFactor_ > MAX_RESAMPLER_PHASES) {
+        std::ostringstream ss;
+        ss << "Cannot resample from " << inputRate << " Hz to " << outputRate << " Hz (" << upFactor_ << " phases)";
+        throw Exception(ss.str().c_str());
+    }
+
+    // as long, in input samples, as the 160th order low pass filter is at 44.1 kHz
+    tapsPerPhase_ = (2 * (unsigned int)ceil(80.0 * inputRate / 44100.0)) + 1;
+
+    // windowed sinc prototype at the upsampled rate, scaled so each phase has
+    // unity gain. Its centre falls on an input sample, so the output lags the
+    // input by exactly (tapsPerPhase - 1) / 2 input samples; the taps past its
+    // end stay zero.
+    unsigned int length = ((tapsPerPhase_ - 1) * upFactor_) + 1;
+    double cutoff = cornerFrequency / ((double)inputRate * upFactor_);
+    double centre = (length - 1) / 2.0;
+    std::vector<double> prototype((size_t)tapsPerPhase_ * upFactor_, 0.0);
+    double sum = 0.0;
+    for (unsigned int n = 0; n < length; n++) {
+        double x = n - centre;
+        double sinc = x == 0 ? 2 * cutoff : sin(2 * PI * cutoff * x) / (PI * x);
+        prototype[n] = sinc * WindowFunction::window(WINDOW_HAMMING, n, length);
+        sum += prototype[n];
+    }
+
+    // output sample u / L of the upsampled stream is the sum over k of
+    // prototype[p + k * L] * input[u / L - k], with p = u % L
+    phases_.resize((size_t)upFactor_ * tapsPerPhase_);
+    for (unsigned int p = 0; p < upFactor_; p++) {
+        float* row = phases_.data() + ((size_t)p * tapsPerPhase_);
+        for (unsigned int k = 0; k < tapsPerPhase_; k++) {
+            row[tapsPerPhase_ - 1 - k] = prototype[p + (k * upFactor_)] * upFactor_ / sum;
+        }
+    }
+}
+
+auto Resampler::getInputRate() const -> unsigned int
+{
+    return inputRate_;
+}
+
+auto Resampler::getOutputRate() const -> unsigned int
+{
+    return outputRate_;
+}
+
+auto Resampler::getUpFactor() const -> unsigned int
+{
+    return upFactor_;
+}
+
+auto Resampler::getDownFactor() const -> unsigned int
+{
+    return downFactor_;
+}
+
+auto Resampler::getTapsPerPhase() const -> unsigned int
+{
+    return tapsPerPhase_;
+}
+
+// The window holds a stretch of the input stream, and position is the
+// upsampled index of the next output relative to the window's first sample:
+// that output reads the tapsPerPhase samples ending at position / L. The
+// remainder buffer keeps the window's unread tail between calls.
+void Resampler::resample(const AudioView& input, AudioData& output, Workspace& workspace, bool flush) const
+{
+    if (input.getFrameRate() != inputRate_) {
+        throw Exception("Audio frame rate doesn't match resampler");
+    }
+    AudioData& history = workspace.remainderBuffer;
+    if (workspace.lpfBuffer == nullptr) {
+        workspace.lpfBuffer = new std::vector<float>();
+    }
+    std::vector<float>& window = *workspace.lpfBuffer;
+    window.resize(history.getSampleCount() + tapsPerPhase_ + RESAMPLER_BLOCK_FRAMES);
+
+    unsigned int filled = 0;
+    unsigned long long position = workspace.resamplePosition;
+    if (position == 0) {
+        // a new stream starts from silence
+        std::fill(window.begin(), window.begin() + tapsPerPhase_ - 1, 0.0);
+        filled = tapsPerPhase_ - 1;
+        position = (unsigned long long)(tapsPerPhase_ - 1) * upFactor_;
+    } else {
+        std::copy(history.getSampleData(), history.getSampleData() + history.getSampleCount(), window.begin());
+        filled = history.getSampleCount();
+    }
+
+    if (output.getChannels() == 0 && output.getFrameRate() == 0) {
+        output.setChannels(1);
+        output.setFrameRate(outputRate_);
+    }
+
+    unsigned int consumed = 0;
+    bool drained = !flush;
+    while (true) {
+        // every output whose newest input sample is in the window
+        unsigned long long available = (unsigned long long)filled * upFactor_;
+        if (position < available) {
+            unsigned int outputs = (available - position + downFactor_ - 1) / downFactor_;
+            unsigned int offset = output.getSampleCount();
+            output.addToSampleCount(outputs);
+            float* outputSamples = output.getSampleData() + offset;
+            for (unsigned int i = 0; i < outputs; i++) {
+                unsigned int newest = position / upFactor_;
+                const float* taps = phases_.data() + ((size_t)(position % upFactor_) * tapsPerPhase_);
+                outputSamples[i] = dotProduct(taps, window.data() + newest + 1 - tapsPerPhase_, tapsPerPhase_);
+                position += downFactor_;
+            }
+        }
+        if (consumed == input.getFrameCount() && drained) {
+            break;
+        }
+
+        // keep only what the next output still needs
+        unsigned int needed = position / upFactor_ + 1 - tapsPerPhase_;
+        unsigned int discard = std::min(needed, filled);
+        std::copy(window.begin() + discard, window.begin() + filled, window.begin());
+        filled -= discard;
+        position -= (unsigned long long)discard * upFactor_;
+
+        if (consumed < input.getFrameCount()) {
+            unsigned int frames = std::min(RESAMPLER_BLOCK_FRAMES, input.getFrameCount() - consumed);
+            input.downmix(consumed, frames, window.data() + filled);
+            consumed += frames;
+            filled += frames;
+        } else {
+            // trailing silence lets the filter's last outputs through
+            std::fill(window.begin() + filled, window.begin() + filled + tapsPerPhase_ - 1, 0.0);
+            filled += tapsPerPhase_ - 1;
+            drained = true;
+        }
+    }
+
+    if (flush) {
+        history.clear();
+        workspace.resamplePosition = 0;
+        return;
+    }
+    // carry the unread tail, which is never more than the filter length
+    unsigned int needed = position / upFactor_ + 1 - tapsPerPhase_;
+    unsigned int discard = std::min(needed, filled);
+    history.clear();
+    history.setChannels(1);
+    history.setFrameRate(inputRate_);
+    history.addToSampleCount(filled - discard);
+    std::copy(window.begin() + discard, window.begin() + filled, history.getSampleData());
+    workspace.resamplePosition = position - ((unsigned long long)discard * upFactor_);
+}
+
+}
@@ -0,0 +1,65 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "audiodata.h"
+#include "audioview.h"
+#include "constants.h"
+#include "workspace.h"
+
+namespace KeyFinder {
+
+// Rational sample rate conversion by a polyphase FIR filter: the input is
+// notionally upsampled by L, low pass filtered and downsampled by M, where
+// L / M is the ratio of the rates in lowest terms. Only the filter taps that
+// meet real input samples are evaluated, one phase per output sample.
+class Resampler {
+public:
+    // Throws if the rates are zero, the corner frequency is not below both
+    // Nyquist frequencies or the rates' ratio needs too many phases.
+    Resampler(unsigned int inputRate, unsigned int outputRate, float cornerFrequency);
+    [[nodiscard]] auto getInputRate() const -> unsigned int;
+    [[nodiscard]] auto getOutputRate() const -> unsigned int;
+    [[nodiscard]] auto getUpFactor() const -> unsigned int;
+    [[nodiscard]] auto getDownFactor() const -> unsigned int;
+    [[nodiscard]] auto getTapsPerPhase() const -> unsigned int;
+
+    // Downmixes the input, resamples it and appends the result to output.
+    // The filter history and phase carry over between calls in the
+    // workspace's remainder buffer and resamplePosition, so a stream can be
+    // fed in chunks of any size; flush drains the filter at the end.
+    void resample(const AudioView& input, AudioData& output, Workspace& workspace, bool flush) const;
+
+private:
+    unsigned int inputRate_;
+    unsigned int outputRate_;
+    unsigned int upFactor_;
+    unsigned int downFactor_;
+    unsigned int tapsPerPhase_;
+    // row p holds the taps of phase p, oldest input sample first
+    std::vector<float> phases_;
+};
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "resamplerfactory.h"
+
+namespace KeyFinder {
+
+ResamplerFactory::ResamplerWrapper::ResamplerWrapper(unsigned int inInputRate, unsigned int inOutputRate, float inCornerFrequency, const Resampler* const inResampler)
+{
+    inputRate_ = inInputRate;
+    outputRate_ = inOutputRate;
+    cornerFrequency_ = inCornerFrequency;
+    resampler_ = inResampler;
+}
+
+ResamplerFactory::ResamplerWrapper::~ResamplerWrapper()
+{
+    delete resampler_;
+}
+
+auto ResamplerFactory::ResamplerWrapper::getResampler() const -> const Resampler*
+{
+    return resampler_;
+}
+
+auto ResamplerFactory::ResamplerWrapper::getInputRate() const -> unsigned int
+{
+    return inputRate_;
+}
+
+auto ResamplerFactory::ResamplerWrapper::getOutputRate() const -> unsigned int
+{
+    return outputRate_;
+}
+
+auto ResamplerFactory::ResamplerWrapper::getCornerFrequency() const -> float
+{
+    return cornerFrequency_;
+}
+
+auto ResamplerFactory::getResampler(unsigned int inInputRate, unsigned int inOutputRate, float inCornerFrequency) -> const Resampler*
+{
+    return resamplers_.find([&](const ResamplerWrapper& wrapper) {
+        return wrapper.getInputRate() == inInputRate && wrapper.getOutputRate() == inOutputRate && wrapper.getCornerFrequency() == inCornerFrequency;
+    }, [&]() {
+        auto* resampler = new Resampler(inInputRate, inOutputRate, inCornerFrequency);
+        return new ResamplerWrapper(inInputRate, inOutputRate, inCornerFrequency, resampler);
+    })->getResampler();
+}
+
+}
@@ -0,0 +1,58 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef RESAMPLERFACTORY_H
+#define RESAMPLERFACTORY_H
+
+#include "constants.h"
+#include "resampler.h"
+#include "snapshotcache.h"
+
+namespace KeyFinder {
+
+class ResamplerFactory {
+public:
+    auto getResampler(unsigned int inputRate, unsigned int outputRate, float cornerFrequency) -> const Resampler*;
+
+private:
+    class ResamplerWrapper;
+    SnapshotCache<ResamplerWrapper> resamplers_;
+};
+
+class ResamplerFactory::ResamplerWrapper {
+public:
+    ResamplerWrapper(unsigned int inputRate, unsigned int outputRate, float cornerFrequency, const Resampler* resampler);
+    ~ResamplerWrapper();
+    [[nodiscard]] auto getResampler() const -> const Resampler*;
+    [[nodiscard]] auto getInputRate() const -> unsigned int;
+    [[nodiscard]] auto getOutputRate() const -> unsigned int;
+    [[nodiscard]] auto getCornerFrequency() const -> float;
+
+private:
+    unsigned int inputRate_;
+    unsigned int outputRate_;
+    float cornerFrequency_;
+    const Resampler* resampler_;
+};
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace KeyFinder {
+
+// An append-only cache of entries, shared by the factories. Lookups read the
+// published list without locking. New entries are added to a copy under the
+// mutex, which then replaces it; replaced lists are kept until destruction
+// since readers may still be scanning them. Entries are owned by the cache.
+template <typename Entry>
+class SnapshotCache {
+public:
+    SnapshotCache()
+        : entries_(new std::vector<Entry*>())
+    {
+    }
+
+    ~SnapshotCache()
+    {
+        const std::vector<Entry*>* entries = entries_.load();
+        for (auto* entry : *entries) {
+            delete entry;
+        }
+        delete entries;
+        for (auto* retired : retired_) {
+            delete retired;
+        }
+    }
+
+    SnapshotCache(const SnapshotCache&) = delete;
+    auto operator=(const SnapshotCache&) -> SnapshotCache& = delete;
+
+    // The first entry for which matches(entry) is true, or else the one
+    // returned by create(), which is called at most once per missing entry.
+    template <typename Matches, typename Create>
+    auto find(const Matches& matches, const Create& create) -> const Entry*
+    {
+        for (auto* entry : *entries_.load(std::memory_order_acquire)) {
+            if (matches(*entry)) {
+                return entry;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        // another thread may have built it while we waited
+        const std::vector<Entry*>* current = entries_.load(std::memory_order_acquire);
+        for (auto* entry : *current) {
+            if (matches(*entry)) {
+                return entry;
+            }
+        }
+        Entry* entry = create();
+        auto* next = new std::vector<Entry*>(*current);
+        next->push_back(entry);
+        retired_.push_back(current);
+        entries_.store(next, std::memory_order_release);
+        return entry;
+    }
+
+private:
+    std::atomic<const std::vector<Entry*>*> entries_;
+    std::vector<const std::vector<Entry*>*> retired_;
+    std::mutex mutex_;
+};
+
+}
+
+#endif
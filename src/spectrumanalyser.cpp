@@ -21,48 +21,88 @@
 
 #include "spectrumanalyser.h"
 
+#include "vectorops.h"
+
 namespace KeyFinder {
 
-SpectrumAnalyser::SpectrumAnalyser(unsigned int frameRate, ChromaTransformFactory* spFactory, TemporalWindowFactory* twFactory)
+SpectrumAnalyser::SpectrumAnalyser(unsigned int frameRate, ChromaTransformFactory* spFactory, TemporalWindowFactory* twFactory, unsigned int inFrameSize, unsigned int inHopSize)
+    : frameSize(inFrameSize)
+    , hopSize(inHopSize)
 {
-    chromaTransform = spFactory->getChromaTransform(frameRate);
-    tw = twFactory->getTemporalWindow(FFTFRAMESIZE);
+    if (hopSize < 1) {
+        throw Exception("Hop size must be > 0");
+    }
+    chromaTransform = spFactory->getChromaTransform(frameRate, frameSize);
+    tw = twFactory->getTemporalWindow(frameSize);
 }
 
-auto SpectrumAnalyser::chromagramOfWholeFrames(AudioData& audio, FftAdapter* const fftAdapter) const -> Chromagram*
+void SpectrumAnalyser::checkFrameSize(const FftAdapter* const fftAdapter) const
+{
+    if (fftAdapter->getFrameSize() != frameSize) {
+        std::ostringstream ss;
+        ss << "FFT frame size (" << fftAdapter->getFrameSize() << ") doesn't match analysis frame size (" << frameSize << ")";
+        throw Exception(ss.str().c_str());
+    }
+}
+
+auto SpectrumAnalyser::chromagramOfWholeFrames(AudioData& audio, FftAdapter* const fftAdapter, AnalysisStats* stats) const -> Chromagram*
 {
 
     if (audio.getChannels() != 1) {
         throw Exception("Audio must be monophonic to be analysed");
     }
 
-    unsigned int frmSize = fftAdapter->getFrameSize();
-    if (audio.getSampleCount() < frmSize) {
+    checkFrameSize(fftAdapter);
+    if (audio.getSampleCount() < frameSize) {
         return new Chromagram(0);
     }
 
-    unsigned int hops = 1 + ((audio.getSampleCount() - frmSize) / HOPSIZE);
-    auto* ch = new Chromagram(hops);
+    unsigned int hops = 1 + ((audio.getSampleCount() - frameSize) / hopSize);
+    return chromagramOfHops(audio, fftAdapter, 0, hops, stats);
+}
 
-    for (unsigned int hop = 0; hop < hops; hop++) {
+auto SpectrumAnalyser::chromagramOfHops(const AudioData& audio, FftAdapter* const fftAdapter, unsigned int firstHop, unsigned int hopCount, AnalysisStats* stats) const -> Chromagram*
+{
 
-        audio.resetIterators();
-        audio.advanceReadIterator(hop * HOPSIZE);
+    if (audio.getChannels() != 1) {
+        throw Exception("Audio must be monophonic to be analysed");
+    }
+
+    checkFrameSize(fftAdapter);
+    if (hopCount > 0 && ((size_t)(firstHop + hopCount - 1) * hopSize) + frameSize > audio.getSampleCount()) {
+        std::ostringstream ss;
+        ss << "Cannot analyse out-of-bounds hop (" << firstHop + hopCount - 1 << ")";
+        throw Exception(ss.str().c_str());
+    }
 
-        auto twIt = tw->begin();
-        for (unsigned int sample = 0; sample < frmSize; sample++) {
-            fftAdapter->setInput(sample, audio.getSampleAtReadIterator() * *twIt);
-            audio.advanceReadIterator();
-            std::advance(twIt, 1);
+    auto* ch = new Chromagram(hopCount);
+
+    const float* samples = audio.getSampleData();
+    const float* window = tw->data();
+    unsigned int batchSize = fftAdapter->getBatchSize();
+
+    for (unsigned int batchHop = 0; batchHop < hopCount; batchHop += batchSize) {
+        unsigned int batchHops = std::min(batchSize, hopCount - batchHop);
+
+        // window every hop of the batch into its own slot of the FFT input
+        {
+            StageTimer timer(stats, STAGE_WINDOWING, batchHops);
+            for (unsigned int t = 0; t < batchHops; t++) {
+                const float* frame = samples + ((size_t)(firstHop + batchHop + t) * hopSize);
+                multiply(frame, window, fftAdapter->getInputBuffer(t), frameSize);
+            }
         }
 
-        fftAdapter->execute();
+        {
+            StageTimer timer(stats, STAGE_FFT, batchHops);
+            fftAdapter->executeBatch(batchHops);
+        }
 
-        std::vector<float> cv = chromaTransform->chromaVector(fftAdapter);
-        auto cvIt = cv.begin();
-        for (unsigned int band = 0; band < BANDS; band++) {
-            ch->setMagnitude(hop, band, *cvIt);
-            std::advance(cvIt, 1);
+        StageTimer timer(stats, STAGE_CHROMA, batchHops);
+        float cv[BANDS];
+        for (unsigned int t = 0; t < batchHops; t++) {
+            chromaTransform->chromaVector(fftAdapter, t, cv);
+            ch->setHop(batchHop + t, cv);
         }
     }
     return ch;
@@ -22,6 +22,7 @@
 #ifndef SPECTRUMANALYSER_H
 #define SPECTRUMANALYSER_H
 
+#include "analysisstats.h"
 #include "audiodata.h"
 #include "chromagram.h"
 #include "chromatransformfactory.h"
@@ -34,12 +35,19 @@ namespace KeyFinder {
 
 class SpectrumAnalyser {
 public:
-    SpectrumAnalyser(unsigned int frameRate, ChromaTransformFactory* spFactory, TemporalWindowFactory* twFactory);
-    auto chromagramOfWholeFrames(AudioData& audio, FftAdapter* fft) const -> Chromagram*;
+    // FFT adapters passed in must transform frames of frameSize samples.
+    SpectrumAnalyser(unsigned int frameRate, ChromaTransformFactory* spFactory, TemporalWindowFactory* twFactory, unsigned int frameSize = FFTFRAMESIZE, unsigned int hopSize = HOPSIZE);
+    auto chromagramOfWholeFrames(AudioData& audio, FftAdapter* fft, AnalysisStats* stats = nullptr) const -> Chromagram*;
+    // Chromagram of hopCount hops starting at firstHop; the audio must hold
+    // every frame they span.
+    auto chromagramOfHops(const AudioData& audio, FftAdapter* fft, unsigned int firstHop, unsigned int hopCount, AnalysisStats* stats = nullptr) const -> Chromagram*;
 
 protected:
+    void checkFrameSize(const FftAdapter* fft) const;
     const ChromaTransform* chromaTransform;
     const std::vector<float>* tw;
+    unsigned int frameSize;
+    unsigned int hopSize;
 };
 
 }
@@ -44,30 +44,13 @@ auto TemporalWindowFactory::TemporalWindowWrapper::getTemporalWindow() const ->
     return &temporalWindow_;
 }
 
-TemporalWindowFactory::TemporalWindowFactory()
-    : temporalWindows_(0)
-{
-}
-
-TemporalWindowFactory::~TemporalWindowFactory()
-{
-    for (auto& temporalWindow : temporalWindows_) {
-        delete temporalWindow;
-    }
-}
-
 auto TemporalWindowFactory::getTemporalWindow(unsigned int frameSize) -> const std::vector<float>*
 {
-    for (auto* wrapper : temporalWindows_) {
-        if (wrapper->getFrameSize() == frameSize) {
-            return wrapper->getTemporalWindow();
-        }
-    }
-    temporalWindowFactoryMutex_.lock();
-    temporalWindows_.push_back(new TemporalWindowWrapper(frameSize));
-    unsigned int newTemporalWindowIndex = temporalWindows_.size() - 1;
-    temporalWindowFactoryMutex_.unlock();
-    return temporalWindows_[newTemporalWindowIndex]->getTemporalWindow();
+    return temporalWindows_.find([&](const TemporalWindowWrapper& wrapper) {
+        return wrapper.getFrameSize() == frameSize;
+    }, [&]() {
+        return new TemporalWindowWrapper(frameSize);
+    })->getTemporalWindow();
 }
 
 }
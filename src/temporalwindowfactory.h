@@ -23,20 +23,19 @@
 #define TEMPORALWINDOWFACTORY_H
 
 #include "constants.h"
+#include "snapshotcache.h"
 #include "windowfunctions.h"
 
+
 namespace KeyFinder {
 
 class TemporalWindowFactory {
 public:
-    TemporalWindowFactory();
-    ~TemporalWindowFactory();
     auto getTemporalWindow(unsigned int frameSize) -> const std::vector<float>*;
 
 private:
     class TemporalWindowWrapper;
-    std::vector<TemporalWindowWrapper*> temporalWindows_;
-    std::mutex temporalWindowFactoryMutex_;
+    SnapshotCache<TemporalWindowWrapper> temporalWindows_;
 };
 
 class TemporalWindowFactory::TemporalWindowWrapper {
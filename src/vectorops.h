@@ -0,0 +1,106 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef VECTOROPS_H
+#define VECTOROPS_H
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define KEYFINDER_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define KEYFINDER_NEON
+#endif
+
+namespace KeyFinder {
+
+// Inner loops shared by the DSP stages, written against raw, contiguous
+// arrays. Compilers don't vectorise a float reduction at -O2 without
+// reassociating it, so the SSE and NEON paths do that explicitly, with
+// VECTOR_LANES independent partial sums. Nor, at -O2, do they vectorise a
+// loop whose length is only known at run time, hence multiply().
+
+constexpr unsigned int VECTOR_LANES = 8;
+
+inline auto dotProduct(const float* a, const float* b, unsigned int n) -> float
+{
+    unsigned int i = 0;
+    float sum = 0.0;
+#if defined(KEYFINDER_SSE)
+    __m128 low = _mm_setzero_ps();
+    __m128 high = _mm_setzero_ps();
+    for (; i + VECTOR_LANES <= n; i += VECTOR_LANES) {
+        low = _mm_add_ps(low, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        high = _mm_add_ps(high, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    float partial[4];
+    _mm_storeu_ps(partial, _mm_add_ps(low, high));
+    sum = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#elif defined(KEYFINDER_NEON)
+    float32x4_t low = vdupq_n_f32(0.0);
+    float32x4_t high = vdupq_n_f32(0.0);
+    for (; i + VECTOR_LANES <= n; i += VECTOR_LANES) {
+        low = vmlaq_f32(low, vld1q_f32(a + i), vld1q_f32(b + i));
+        high = vmlaq_f32(high, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float partial[4];
+    vst1q_f32(partial, vaddq_f32(low, high));
+    sum = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+#else
+    float partial[VECTOR_LANES] = { 0.0 };
+    for (; i + VECTOR_LANES <= n; i += VECTOR_LANES) {
+        for (unsigned int lane = 0; lane < VECTOR_LANES; lane++) {
+            partial[lane] += a[i + lane] * b[i + lane];
+        }
+    }
+    for (float p : partial) {
+        sum += p;
+    }
+#endif
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// output[i] = a[i] * b[i]
+inline void multiply(const float* a, const float* b, float* output, unsigned int n)
+{
+    unsigned int i = 0;
+#if defined(KEYFINDER_SSE)
+    for (; i + VECTOR_LANES <= n; i += VECTOR_LANES) {
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+#elif defined(KEYFINDER_NEON)
+    for (; i + VECTOR_LANES <= n; i += VECTOR_LANES) {
+        vst1q_f32(output + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+        vst1q_f32(output + i + 4, vmulq_f32(vld1q_f32(a + i + 4), vld1q_f32(b + i + 4)));
+    }
+#endif
+    for (; i < n; i++) {
+        output[i] = a[i] * b[i];
+    }
+}
+
+}
+
+#endif
@@ -28,6 +28,32 @@ Workspace::Workspace()
 {
 }
 
+void Workspace::reset()
+{
+    remainderBuffer.clear();
+    preprocessedBuffer.clear();
+    decimationPosition = 0;
+    resamplePosition = 0;
+    if (chromagram != nullptr) {
+        chromagram->clear();
+    }
+}
+
+void Workspace::retainRecentHops(unsigned int hops)
+{
+    if (chromagram == nullptr) {
+        chromagram = new Chromagram(0);
+    }
+    chromagram->retainRecentHops(hops);
+}
+
+void Workspace::retainAllHops()
+{
+    if (chromagram != nullptr) {
+        chromagram->retainAllHops();
+    }
+}
+
 Workspace::~Workspace()
 {
     {
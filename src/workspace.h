@@ -22,6 +22,7 @@
 #ifndef WORKSPACE_H
 #define WORKSPACE_H
 
+#include "analysisstats.h"
 #include "audiodata.h"
 #include "binode.h"
 #include "chromagram.h"
@@ -33,11 +34,25 @@ class Workspace {
 public:
     Workspace();
     ~Workspace();
+    // Clears the analysis state so the workspace can start on a new track,
+    // keeping its buffers and FFT plans. The stats pointer is left alone.
+    void reset();
+    // For streams of unbounded length: keeps only the running band totals
+    // and the most recent hops of the chromagram, so memory stays constant.
+    // The key is unaffected. Lasts until retainAllHops() is called.
+    void retainRecentHops(unsigned int hops);
+    void retainAllHops();
     AudioData remainderBuffer;
     AudioData preprocessedBuffer;
     Chromagram* chromagram { nullptr };
     FftAdapter* fftAdapter { nullptr };
     std::vector<float>* lpfBuffer { nullptr };
+    // where the preprocessing filters are in the stream, for the history kept
+    // in remainderBuffer; 0 before the first sample
+    unsigned long long decimationPosition { 0 };
+    unsigned long long resamplePosition { 0 };
+    // optional and owned by the caller; KeyFinder records into it when set
+    AnalysisStats* stats { nullptr };
 };
 
 }
@@ -0,0 +1,65 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "workspacepool.h"
+
+namespace KeyFinder {
+
+WorkspacePool::~WorkspacePool()
+{
+    for (auto* workspace : idle_) {
+        delete workspace;
+    }
+}
+
+auto WorkspacePool::acquire() -> Workspace*
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            Workspace* workspace = idle_.back();
+            idle_.pop_back();
+            return workspace;
+        }
+    }
+    return new Workspace();
+}
+
+void WorkspacePool::release(Workspace* workspace)
+{
+    if (workspace == nullptr) {
+        return;
+    }
+    // reset outside the lock; only the list itself is shared
+    workspace->reset();
+    workspace->retainAllHops();
+    workspace->stats = nullptr;
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(workspace);
+}
+
+auto WorkspacePool::getIdleCount() const -> unsigned int
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+}
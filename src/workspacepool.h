@@ -0,0 +1,53 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef WORKSPACEPOOL_H
+#define WORKSPACEPOOL_H
+
+#include "constants.h"
+#include "workspace.h"
+
+namespace KeyFinder {
+
+// Hands out workspaces that have already been used, so their buffers and FFT
+// plans carry over from one track to the next. Safe to share between threads.
+class WorkspacePool {
+public:
+    WorkspacePool() = default;
+    ~WorkspacePool();
+    WorkspacePool(const WorkspacePool&) = delete;
+    auto operator=(const WorkspacePool&) -> WorkspacePool& = delete;
+
+    // An idle workspace, or a new one if none is idle. Give it back with
+    // release() when done; the pool resets it, detaches any stats and
+    // lifts any hop retention limit.
+    auto acquire() -> Workspace*;
+    void release(Workspace* workspace);
+    [[nodiscard]] auto getIdleCount() const -> unsigned int;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<Workspace*> idle_;
+};
+
+}
+
+#endif
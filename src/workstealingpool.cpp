@@ -0,0 +1,114 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+namespace KeyFinder {
+
+class WorkStealingQueue {
+public:
+    std::mutex mutex;
+    // ordered most to least expensive
+    std::deque<unsigned int> tasks;
+};
+
+void WorkStealingPool::run(const std::vector<unsigned long long>& costs, unsigned int threadCount, const std::function<void(unsigned int)>& task)
+{
+    if (costs.empty()) {
+        return;
+    }
+    threadCount = std::max(1U, std::min(threadCount, (unsigned int)costs.size()));
+
+    std::vector<unsigned int> order(costs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&costs](unsigned int a, unsigned int b) { return costs[a] > costs[b]; });
+
+    // deal round robin so every queue starts with a similar share of the work
+    std::vector<std::unique_ptr<WorkStealingQueue>> queues;
+    for (unsigned int t = 0; t < threadCount; t++) {
+        queues.push_back(std::make_unique<WorkStealingQueue>());
+    }
+    for (unsigned int i = 0; i < order.size(); i++) {
+        queues[i % threadCount]->tasks.push_back(order[i]);
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto work = [&](unsigned int self) {
+        while (true) {
+            bool found = false;
+            unsigned int next = 0;
+            // own queue from the expensive end, other queues from the cheap end
+            for (unsigned int q = 0; q < threadCount && !found; q++) {
+                WorkStealingQueue& queue = *queues[(self + q) % threadCount];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.tasks.empty()) {
+                    if (q == 0) {
+                        next = queue.tasks.front();
+                        queue.tasks.pop_front();
+                    } else {
+                        next = queue.tasks.back();
+                        queue.tasks.pop_back();
+                    }
+                    found = true;
+                }
+            }
+            // no task is ever added, so empty queues everywhere means done
+            if (!found) {
+                return;
+            }
+            try {
+                task(next);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (error == nullptr) {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < threadCount; t++) {
+        try {
+            threads.emplace_back(work, t);
+        } catch (...) {
+            // fewer threads just means more stealing
+            break;
+        }
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+}
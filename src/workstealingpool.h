@@ -0,0 +1,45 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include "constants.h"
+
+#include <functional>
+
+namespace KeyFinder {
+
+// Runs a fixed set of independent tasks of known relative cost on several
+// threads. Tasks are dealt out longest first, each thread working from its
+// own queue; a thread whose queue runs dry steals the cheapest remaining task
+// from another, so a few long tasks can't leave the other threads idle.
+class WorkStealingPool {
+public:
+    // Calls task(i) for every i in [0, costs.size()) using up to threadCount
+    // threads, the calling thread included, and returns once all have run.
+    // If tasks throw, the rest still run and the first exception is rethrown.
+    static void run(const std::vector<unsigned long long>& costs, unsigned int threadCount, const std::function<void(unsigned int)>& task);
+};
+
+}
+
+#endif
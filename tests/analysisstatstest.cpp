@@ -0,0 +1,85 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "_testhelpers.h"
+
+TEST(AnalysisStatsTest, RecordsAndClears)
+{
+    KeyFinder::AnalysisStats stats;
+    ASSERT_EQ(0, stats.getStage(KeyFinder::STAGE_FFT).calls);
+
+    stats.record(KeyFinder::STAGE_FFT, 2.0, 1.0, 4);
+    stats.record(KeyFinder::STAGE_FFT, 1.0, 0.5, 3);
+    KeyFinder::AnalysisStats::Stage fft = stats.getStage(KeyFinder::STAGE_FFT);
+    ASSERT_EQ(2, fft.calls);
+    ASSERT_EQ(7, fft.items);
+    ASSERT_FLOAT_EQ(3.0, fft.wallSeconds);
+    ASSERT_FLOAT_EQ(1.5, fft.cpuSeconds);
+    ASSERT_EQ(0, stats.getStage(KeyFinder::STAGE_CHROMA).calls);
+
+    stats.clear();
+    ASSERT_EQ(0, stats.getStage(KeyFinder::STAGE_FFT).calls);
+    ASSERT_EQ(0, stats.getStage(KeyFinder::STAGE_FFT).items);
+}
+
+TEST(AnalysisStatsTest, StageTimer)
+{
+    KeyFinder::AnalysisStats stats;
+    {
+        KeyFinder::StageTimer timer(&stats, KeyFinder::STAGE_CHROMA, 5);
+    }
+    {
+        KeyFinder::StageTimer timer(nullptr, KeyFinder::STAGE_CHROMA, 5);
+    }
+    KeyFinder::AnalysisStats::Stage chroma = stats.getStage(KeyFinder::STAGE_CHROMA);
+    ASSERT_EQ(1, chroma.calls);
+    ASSERT_EQ(5, chroma.items);
+    ASSERT_GE(chroma.wallSeconds, 0.0);
+    ASSERT_GE(chroma.cpuSeconds, 0.0);
+}
+
+TEST(AnalysisStatsTest, KeyFinderRecordsEveryStage)
+{
+    unsigned int frameRate = 44100;
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(frameRate * 5);
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        a.setSample(i, sine_wave(i, 440, frameRate, 1));
+    }
+
+    KeyFinder::AnalysisStats stats;
+    KeyFinder::Workspace w;
+    w.stats = &stats;
+    KeyFinder::KeyFinder kf;
+    kf.progressiveChromagram(a, w);
+    kf.finalChromagram(w);
+    static_cast<void>(kf.keyOfChromagram(w));
+
+    ASSERT_EQ(a.getFrameCount(), stats.getStage(KeyFinder::STAGE_PREPROCESS).items);
+    for (auto stage : { KeyFinder::STAGE_WINDOWING, KeyFinder::STAGE_FFT, KeyFinder::STAGE_CHROMA }) {
+        ASSERT_EQ(w.chromagram->getHops(), stats.getStage(stage).items);
+        ASSERT_GT(stats.getStage(stage).calls, 0);
+    }
+    ASSERT_EQ(1, stats.getStage(KeyFinder::STAGE_CLASSIFICATION).calls);
+    ASSERT_EQ(std::string("fft"), KeyFinder::AnalysisStats::getStageName(KeyFinder::STAGE_FFT));
+}
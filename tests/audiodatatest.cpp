@@ -231,6 +231,78 @@ TEST_CASE("AudioDataTest/DiscardFromFront")
     ASSERT_FLOAT_EQ(10.0, a.getSampleByFrame(0, 0));
 }
 
+TEST_CASE("AudioDataTest/DiscardFromBack")
+{
+    KeyFinder::AudioData a;
+
+    a.setChannels(2);
+    a.setFrameRate(1);
+
+    ASSERT_THROW(a.discardFramesFromBack(1), KeyFinder::Exception);
+    a.addToFrameCount(10);
+    ASSERT_THROW(a.discardFramesFromBack(11), KeyFinder::Exception);
+    ASSERT_NO_THROW(a.discardFramesFromBack(0));
+    a.setSampleByFrame(4, 1, 10.0);
+    ASSERT_NO_THROW(a.discardFramesFromBack(5));
+    ASSERT_EQ(5, a.getFrameCount());
+    ASSERT_FLOAT_EQ(10.0, a.getSampleByFrame(4, 1));
+}
+
+TEST_CASE("AudioDataTest/DiscardThenPrependReusesFront")
+{
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(1);
+    a.addToFrameCount(10);
+    for (unsigned int i = 0; i < 10; i++) {
+        a.setSample(i, (float)i);
+    }
+
+    a.discardFramesFromFront(3);
+    ASSERT_EQ(7, a.getSampleCount());
+    ASSERT_FLOAT_EQ(3.0, a.getSample(0));
+
+    KeyFinder::AudioData b;
+    b.setChannels(1);
+    b.setFrameRate(1);
+    b.addToFrameCount(2);
+    b.setSample(0, 100.0);
+    b.setSample(1, 200.0);
+    a.prepend(b);
+    ASSERT_EQ(9, a.getSampleCount());
+    ASSERT_FLOAT_EQ(100.0, a.getSample(0));
+    ASSERT_FLOAT_EQ(200.0, a.getSample(1));
+    ASSERT_FLOAT_EQ(3.0, a.getSample(2));
+
+    // discarding most of the buffer compacts it without disturbing the rest
+    a.discardFramesFromFront(7);
+    ASSERT_EQ(2, a.getSampleCount());
+    ASSERT_FLOAT_EQ(8.0, a.getSample(0));
+    ASSERT_FLOAT_EQ(9.0, a.getSample(1));
+    a.append(b);
+    ASSERT_EQ(4, a.getSampleCount());
+    ASSERT_FLOAT_EQ(200.0, a.getSample(3));
+}
+
+TEST_CASE("AudioDataTest/SampleDataIsContiguous")
+{
+    KeyFinder::AudioData a;
+    a.setChannels(2);
+    a.setFrameRate(1);
+    a.addToFrameCount(4);
+    for (unsigned int i = 0; i < 8; i++) {
+        a.setSample(i, (float)i);
+    }
+    a.discardFramesFromFront(1);
+
+    const float* data = a.getSampleData();
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        ASSERT_FLOAT_EQ(a.getSample(i), data[i]);
+    }
+    a.getSampleData()[0] = 50.0;
+    ASSERT_FLOAT_EQ(50.0, a.getSampleByFrame(0, 0));
+}
+
 TEST_CASE("AudioDataTest/SliceFromBack")
 {
     KeyFinder::AudioData a;
@@ -406,3 +478,20 @@ TEST_CASE("AudioDataTest/Iterators")
     ASSERT_FALSE(a.readIteratorWithinUpperBound());
     ASSERT_FALSE(a.writeIteratorWithinUpperBound());
 }
+
+TEST(AudioDataTest, ClearResetsState)
+{
+    KeyFinder::AudioData a;
+    a.setChannels(2);
+    a.setFrameRate(44100);
+    a.addToFrameCount(10);
+    a.advanceReadIterator(2);
+    a.clear();
+    ASSERT_EQ(0, a.getChannels());
+    ASSERT_EQ(0, a.getFrameRate());
+    ASSERT_EQ(0, a.getSampleCount());
+    a.setChannels(1);
+    a.addToSampleCount(3);
+    a.resetIterators();
+    ASSERT_FLOAT_EQ(0.0, a.getSampleAtReadIterator());
+}
@@ -0,0 +1,191 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "_testhelpers.h"
+
+#include <climits>
+#include <limits>
+
+TEST_CASE("AudioViewTest/ConstructorWorks")
+{
+    float samples[6] = { 0.0 };
+    KeyFinder::AudioView v(samples, 3, 2, 44100);
+    ASSERT_EQ(samples, v.getData());
+    ASSERT_EQ(3, v.getFrameCount());
+    ASSERT_EQ(2, v.getChannels());
+    ASSERT_EQ(44100, v.getFrameRate());
+    ASSERT_EQ(KeyFinder::SAMPLE_FORMAT_FLOAT32, v.getSampleFormat());
+}
+
+TEST_CASE("AudioViewTest/ConstructorValidates")
+{
+    float samples[2] = { 0.0 };
+    ASSERT_THROW(KeyFinder::AudioView(samples, 1, 0, 44100), KeyFinder::Exception);
+    ASSERT_THROW(KeyFinder::AudioView(samples, 1, 2, 0), KeyFinder::Exception);
+    ASSERT_THROW(KeyFinder::AudioView(nullptr, 1, 2, 44100), KeyFinder::Exception);
+    ASSERT_NO_THROW(KeyFinder::AudioView(nullptr, 0, 2, 44100));
+}
+
+TEST_CASE("AudioViewTest/DownmixFloat")
+{
+    float samples[8] = { 1.0, 3.0, 2.0, 4.0, -1.0, 1.0, 10.0, 20.0 };
+    KeyFinder::AudioView v(samples, 4, 2, 44100);
+    float mono[4];
+    v.downmix(0, 4, mono);
+    ASSERT_FLOAT_EQ(2.0, mono[0]);
+    ASSERT_FLOAT_EQ(3.0, mono[1]);
+    ASSERT_FLOAT_EQ(0.0, mono[2]);
+    ASSERT_FLOAT_EQ(15.0, mono[3]);
+
+    v.downmix(2, 2, mono);
+    ASSERT_FLOAT_EQ(0.0, mono[0]);
+    ASSERT_FLOAT_EQ(15.0, mono[1]);
+
+    ASSERT_THROW(v.downmix(3, 2, mono), KeyFinder::Exception);
+    // bounds that would wrap if summed
+    ASSERT_THROW(v.downmix(2, UINT_MAX - 1, mono), KeyFinder::Exception);
+    ASSERT_THROW(v.downmix(UINT_MAX, 2, mono), KeyFinder::Exception);
+}
+
+TEST_CASE("AudioViewTest/DownmixRejectsNonFiniteFloats")
+{
+    float samples[4] = { 1.0, 2.0, 3.0, 4.0 };
+    KeyFinder::AudioView v(samples, 4, 1, 44100);
+    float mono[4];
+    samples[2] = std::numeric_limits<float>::quiet_NaN();
+    ASSERT_THROW(v.downmix(0, 4, mono), KeyFinder::Exception);
+    ASSERT_NO_THROW(v.downmix(0, 2, mono));
+    samples[2] = std::numeric_limits<float>::infinity();
+    ASSERT_THROW(v.downmix(0, 4, mono), KeyFinder::Exception);
+
+    // a double too large for a float is infinite once converted
+    double wide[2] = { 0.5, 1e300 };
+    KeyFinder::AudioView w(wide, 1, 2, 44100, KeyFinder::SAMPLE_FORMAT_FLOAT64);
+    ASSERT_THROW(w.downmix(0, 1, mono), KeyFinder::Exception);
+}
+
+TEST_CASE("AudioViewTest/DownmixScalesIntegerFormats")
+{
+    int16_t shorts[4] = { 16384, 16384, -32768, 0 };
+    KeyFinder::AudioView s(shorts, 2, 2, 44100, KeyFinder::SAMPLE_FORMAT_INT16);
+    float mono[2];
+    s.downmix(0, 2, mono);
+    ASSERT_FLOAT_EQ(0.5, mono[0]);
+    ASSERT_FLOAT_EQ(-0.5, mono[1]);
+
+    int32_t ints[2] = { 1073741824, -2147483647 - 1 };
+    KeyFinder::AudioView i(ints, 2, 1, 44100, KeyFinder::SAMPLE_FORMAT_INT32);
+    i.downmix(0, 2, mono);
+    ASSERT_FLOAT_EQ(0.5, mono[0]);
+    ASSERT_FLOAT_EQ(-1.0, mono[1]);
+}
+
+TEST_CASE("AudioViewTest/DownmixPackedAndWideFormats")
+{
+    // 0.5 and -1.0 in packed little-endian 24 bit
+    unsigned char packed[6] = { 0x00, 0x00, 0x40, 0x00, 0x00, 0x80 };
+    KeyFinder::AudioView p(packed, 2, 1, 44100, KeyFinder::SAMPLE_FORMAT_INT24);
+    float mono[2];
+    p.downmix(0, 2, mono);
+    ASSERT_FLOAT_EQ(0.5, mono[0]);
+    ASSERT_FLOAT_EQ(-1.0, mono[1]);
+
+    uint8_t bytes[4] = { 192, 192, 0, 128 };
+    KeyFinder::AudioView b(bytes, 2, 2, 44100, KeyFinder::SAMPLE_FORMAT_UINT8);
+    b.downmix(0, 2, mono);
+    ASSERT_FLOAT_EQ(0.5, mono[0]);
+    ASSERT_FLOAT_EQ(-0.5, mono[1]);
+
+    double doubles[2] = { 0.25, -0.75 };
+    KeyFinder::AudioView d(doubles, 2, 1, 44100, KeyFinder::SAMPLE_FORMAT_FLOAT64);
+    d.downmix(0, 2, mono);
+    ASSERT_FLOAT_EQ(0.25, mono[0]);
+    ASSERT_FLOAT_EQ(-0.75, mono[1]);
+
+    ASSERT_EQ(3, KeyFinder::AudioView::getSampleSize(KeyFinder::SAMPLE_FORMAT_INT24));
+    ASSERT_EQ(8, KeyFinder::AudioView::getSampleSize(KeyFinder::SAMPLE_FORMAT_FLOAT64));
+}
+
+TEST_CASE("AudioViewTest/DownmixSelectedChannels")
+{
+    // four channels: two stereo stems
+    int16_t samples[8] = { 1000, 3000, 100, 300, -2000, 0, 500, 700 };
+    KeyFinder::AudioView v(samples, 2, 4, 44100, KeyFinder::SAMPLE_FORMAT_INT16);
+    float mono[2];
+
+    v.downmix(0, 2, mono);
+    ASSERT_NEAR(1100 / 32768.0, mono[0], 0.000001);
+    ASSERT_NEAR(-200 / 32768.0, mono[1], 0.000001);
+
+    v.selectChannels({ 2, 3 });
+    v.downmix(0, 2, mono);
+    ASSERT_NEAR(200 / 32768.0, mono[0], 0.000001);
+    ASSERT_NEAR(600 / 32768.0, mono[1], 0.000001);
+
+    v.selectChannels({ 1 });
+    v.downmix(0, 2, mono);
+    ASSERT_NEAR(3000 / 32768.0, mono[0], 0.000001);
+    ASSERT_NEAR(0.0, mono[1], 0.000001);
+
+    ASSERT_THROW(v.selectChannels({ 4 }), KeyFinder::Exception);
+    ASSERT_EQ(1, v.getSelectedChannels().size());
+    v.selectChannels({});
+    v.downmix(1, 1, mono);
+    ASSERT_NEAR(-200 / 32768.0, mono[0], 0.000001);
+}
+
+TEST_CASE("AudioViewTest/SubView")
+{
+    int16_t samples[8] = { 1000, 3000, 100, 300, -2000, 0, 500, 700 };
+    KeyFinder::AudioView v(samples, 4, 2, 44100, KeyFinder::SAMPLE_FORMAT_INT16);
+    v.selectChannels({ 1 });
+
+    KeyFinder::AudioView tail = v.subView(2, 2);
+    ASSERT_EQ(2, tail.getFrameCount());
+    ASSERT_EQ(44100, tail.getFrameRate());
+    ASSERT_EQ(KeyFinder::SAMPLE_FORMAT_INT16, tail.getSampleFormat());
+    ASSERT_EQ(1, tail.getSelectedChannels().size());
+    float mono[2];
+    tail.downmix(0, 2, mono);
+    ASSERT_NEAR(0.0, mono[0], 0.000001);
+    ASSERT_NEAR(700 / 32768.0, mono[1], 0.000001);
+
+    ASSERT_EQ(0, v.subView(4, 0).getFrameCount());
+    ASSERT_THROW(v.subView(3, 2), KeyFinder::Exception);
+    ASSERT_THROW(v.subView(5, 0), KeyFinder::Exception);
+}
+
+TEST_CASE("AudioViewTest/DownmixMatchesScalarConversion")
+{
+    // long enough to run the vectorised loops and their scalar tails
+    const unsigned int frames = 1003;
+    std::vector<int16_t> stereo(frames * 2);
+    for (unsigned int i = 0; i < stereo.size(); i++) {
+        stereo[i] = (int16_t)((i * 7919) % 65536 - 32768);
+    }
+    KeyFinder::AudioView v(stereo.data(), frames, 2, 44100, KeyFinder::SAMPLE_FORMAT_INT16);
+    std::vector<float> mono(frames);
+    v.downmix(0, frames, mono.data());
+    for (unsigned int f = 0; f < frames; f++) {
+        float expected = (stereo[f * 2] / 32768.0f + stereo[f * 2 + 1] / 32768.0f) / 2;
+        ASSERT_NEAR(expected, mono[f], 0.000001);
+    }
+}
@@ -116,3 +116,109 @@ TEST(ChromagramTest, CollapseToOneHop)
     ASSERT_EQ(72, d.size());
     ASSERT_FLOAT_EQ(15.0, d[0]);
 }
+
+TEST(ChromagramTest, HopWrites)
+{
+    std::vector<float> row(BANDS);
+    for (unsigned int b = 0; b < BANDS; b++) {
+        row[b] = b;
+    }
+
+    KeyFinder::Chromagram c(2);
+    c.setHop(1, row.data());
+    c.appendHop(row.data());
+    ASSERT_EQ(3, c.getHops());
+    for (unsigned int b = 0; b < BANDS; b++) {
+        ASSERT_FLOAT_EQ(0.0, c.getMagnitude(0, b));
+        ASSERT_FLOAT_EQ(b, c.getMagnitude(1, b));
+        ASSERT_FLOAT_EQ(b, c.getHop(2)[b]);
+    }
+
+    ASSERT_THROW(c.setHop(3, row.data()), KeyFinder::Exception);
+    ASSERT_THROW(c.getHop(3), KeyFinder::Exception);
+    row[5] = NAN;
+    ASSERT_THROW(c.setHop(0, row.data()), KeyFinder::Exception);
+    ASSERT_THROW(c.appendHop(row.data()), KeyFinder::Exception);
+    ASSERT_EQ(3, c.getHops());
+}
+
+TEST(ChromagramTest, CollapseTracksOverwritesAndAppends)
+{
+    KeyFinder::Chromagram c(2);
+    c.setMagnitude(0, 0, 10.0);
+    c.setMagnitude(0, 0, 4.0);
+    c.setMagnitude(1, 0, 8.0);
+
+    KeyFinder::Chromagram d(1);
+    d.setMagnitude(0, 0, 3.0);
+    c.append(d);
+
+    std::vector<float> oneHop = c.collapseToOneHop();
+    ASSERT_FLOAT_EQ(5.0, oneHop[0]);
+    ASSERT_FLOAT_EQ(0.0, oneHop[1]);
+
+    KeyFinder::Chromagram empty;
+    ASSERT_FLOAT_EQ(0.0, empty.collapseToOneHop()[0]);
+}
+
+TEST(ChromagramTest, Clear)
+{
+    KeyFinder::Chromagram c(2);
+    c.setMagnitude(1, 0, 10.0);
+    c.clear();
+    ASSERT_EQ(0, c.getHops());
+    c.append(KeyFinder::Chromagram(1));
+    ASSERT_FLOAT_EQ(0.0, c.collapseToOneHop()[0]);
+}
+
+TEST(ChromagramTest, RetainRecentHops)
+{
+    std::vector<float> row(BANDS, 0.0);
+    KeyFinder::Chromagram c;
+    c.retainRecentHops(3);
+    for (unsigned int h = 0; h < 200; h++) {
+        row[0] = h;
+        c.appendHop(row.data());
+    }
+    ASSERT_EQ(200, c.getHops());
+    ASSERT_EQ(197, c.getFirstRetainedHop());
+    for (unsigned int h = 197; h < 200; h++) {
+        ASSERT_FLOAT_EQ(h, c.getMagnitude(h, 0));
+    }
+    ASSERT_THROW(c.getMagnitude(196, 0), KeyFinder::Exception);
+    ASSERT_THROW(c.setHop(0, row.data()), KeyFinder::Exception);
+    // totals still cover the discarded hops
+    ASSERT_FLOAT_EQ(99.5, c.collapseToOneHop()[0]);
+
+    c.setMagnitude(199, 0, 0.0);
+    ASSERT_NEAR(99.5 - 199.0 / 200, c.collapseToOneHop()[0], 0.0001);
+}
+
+TEST(ChromagramTest, RetainNoHops)
+{
+    KeyFinder::Chromagram c;
+    c.retainRecentHops(0);
+    KeyFinder::Chromagram d(2);
+    d.setMagnitude(0, 0, 2.0);
+    d.setMagnitude(1, 0, 4.0);
+    c.append(d);
+    ASSERT_EQ(2, c.getHops());
+    ASSERT_EQ(2, c.getFirstRetainedHop());
+    ASSERT_FLOAT_EQ(3.0, c.collapseToOneHop()[0]);
+
+    // a bounded chromagram appends only the hops it kept
+    KeyFinder::Chromagram e(1);
+    e.append(c);
+    ASSERT_EQ(3, e.getHops());
+    ASSERT_EQ(3, e.getFirstRetainedHop());
+    ASSERT_FLOAT_EQ(2.0, e.collapseToOneHop()[0]);
+
+    c.clear();
+    ASSERT_EQ(0, c.getFirstRetainedHop());
+    c.append(d);
+    ASSERT_EQ(2, c.getFirstRetainedHop());
+    c.retainAllHops();
+    c.append(d);
+    ASSERT_EQ(4, c.getHops());
+    ASSERT_FLOAT_EQ(4.0, c.getMagnitude(3, 0));
+}
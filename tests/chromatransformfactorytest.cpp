@@ -21,6 +21,8 @@
 
 #include "_testhelpers.h"
 
+#include <thread>
+
 TEST(ChromaTransformFactoryTest, RepeatedTransformRequests)
 {
     KeyFinder::ChromaTransformFactory ctf;
@@ -32,3 +34,38 @@ TEST(ChromaTransformFactoryTest, RepeatedTransformRequests)
     ASSERT_EQ(ct1, ct2);
     ASSERT_NE(ct2, ct3);
 }
+
+TEST(ChromaTransformFactoryTest, TransformsPerFrameSize)
+{
+    KeyFinder::ChromaTransformFactory ctf;
+
+    const KeyFinder::ChromaTransform* ct1 = ctf.getChromaTransform(4410);
+    const KeyFinder::ChromaTransform* ct2 = ctf.getChromaTransform(4410, FFTFRAMESIZE);
+    const KeyFinder::ChromaTransform* ct3 = ctf.getChromaTransform(4410, 8192);
+
+    ASSERT_EQ(ct1, ct2);
+    ASSERT_NE(ct1, ct3);
+    ASSERT_EQ(ct3, ctf.getChromaTransform(4410, 8192));
+    ASSERT_THROW(ctf.getChromaTransform(4410, 1024), KeyFinder::Exception);
+}
+
+TEST(ChromaTransformFactoryTest, ConcurrentRequestsShareTransforms)
+{
+    KeyFinder::ChromaTransformFactory ctf;
+    std::vector<unsigned int> frameRates = { 4410, 4800, 8000, 4410, 4800, 8000 };
+    std::vector<const KeyFinder::ChromaTransform*> results(frameRates.size() * 4, nullptr);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < results.size(); t++) {
+        threads.emplace_back([&ctf, &frameRates, &results, t]() {
+            results[t] = ctf.getChromaTransform(frameRates[t % frameRates.size()]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (unsigned int t = 0; t < results.size(); t++) {
+        ASSERT_EQ(ctf.getChromaTransform(frameRates[t % frameRates.size()]), results[t]);
+    }
+}
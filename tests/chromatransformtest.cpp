@@ -57,7 +57,14 @@ public:
     {
     }
     auto getChromaBandFftBinOffsets() -> std::vector<unsigned int> { return chromaBandFftBinOffsets; }
-    auto getDirectSpectralKernel() -> std::vector<std::vector<float>> { return directSpectralKernel; }
+    auto getDirectSpectralKernel() -> std::vector<std::vector<float>>
+    {
+        std::vector<std::vector<float>> kernel(BANDS);
+        for (unsigned int i = 0; i < BANDS; i++) {
+            kernel[i].assign(directSpectralKernel.begin() + kernelBandOffsets[i], directSpectralKernel.begin() + kernelBandOffsets[i + 1]);
+        }
+        return kernel;
+    }
 };
 
 /*TEST (ChromaTransformTest, TestSpectralKernel) {
@@ -100,3 +107,27 @@ public:
     ASSERT_NEAR(KeyFinder::getFrequencyOfBand(i), peakFrequency, 0.2);
   }
 }*/
+
+TEST(ChromaTransformTest, ChromaVectorMatchesPerBinSums)
+{
+    unsigned int frameRate = 4410;
+    MyChromaTransform ct(frameRate);
+    std::vector<unsigned int> cbfbo = ct.getChromaBandFftBinOffsets();
+    std::vector<std::vector<float>> dsk = ct.getDirectSpectralKernel();
+
+    KeyFinder::FftAdapter fft(FFTFRAMESIZE);
+    for (unsigned int i = 0; i < FFTFRAMESIZE; i++) {
+        fft.setInput(i, sin(i * 0.37) + 0.5 * cos(i * 1.9) + ((i * 7919) % 101) / 101.0);
+    }
+    fft.execute();
+
+    std::vector<float> cv = ct.chromaVector(&fft);
+    ASSERT_EQ(BANDS, cv.size());
+    for (unsigned int i = 0; i < BANDS; i++) {
+        float expected = 0.0;
+        for (unsigned int j = 0; j < dsk[i].size(); j++) {
+            expected += fft.getOutputMagnitude(cbfbo[i] + j) * dsk[i][j];
+        }
+        ASSERT_NEAR(expected, cv[i], expected * 0.00001);
+    }
+}
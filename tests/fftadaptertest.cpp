@@ -73,3 +73,70 @@ TEST(FftAdapterTest, ForwardAndBackward)
         ASSERT_NEAR(original[i], backwards.getOutput(i), 0.01f);
     }
 }
+
+TEST(FftAdapterTest, BatchMatchesSingleTransforms)
+{
+    // 1002 leaves all but the first frame of a batch unaligned
+    for (unsigned int frameSize : { 1024U, 1002U }) {
+        unsigned int batchSize = 3;
+        KeyFinder::FftAdapter single(frameSize);
+        KeyFinder::FftAdapter batched(frameSize, batchSize);
+        ASSERT_EQ(batchSize, batched.getBatchSize());
+        ASSERT_THROW(batched.getInputBuffer(batchSize), KeyFinder::Exception);
+        ASSERT_THROW(batched.executeBatch(batchSize + 1), KeyFinder::Exception);
+
+        for (unsigned int t = 0; t < batchSize; t++) {
+            float* input = batched.getInputBuffer(t);
+            for (unsigned int i = 0; i < frameSize; i++) {
+                input[i] = sine_wave(i, 10 + t * 7, frameSize, 1000);
+            }
+        }
+
+        // full batch, then partial batches which take the single-transform route
+        for (unsigned int transformCount : { batchSize, 1U, 2U }) {
+            batched.executeBatch(transformCount);
+            for (unsigned int t = 0; t < transformCount; t++) {
+                for (unsigned int i = 0; i < frameSize; i++) {
+                    single.setInput(i, batched.getInputBuffer(t)[i]);
+                }
+                single.execute();
+                for (unsigned int i = 0; i < frameSize; i++) {
+                    ASSERT_NEAR(single.getOutputMagnitude(i), batched.getOutputMagnitude(t, i), 0.01);
+                }
+            }
+        }
+    }
+}
+
+TEST(FftAdapterTest, MeasuredPlansMatchEstimatedPlans)
+{
+    unsigned int frameSize = 1024;
+    ASSERT_EQ(KeyFinder::FFT_PLANNING_ESTIMATE, KeyFinder::getFftPlanning());
+    KeyFinder::FftAdapter estimated(frameSize);
+    KeyFinder::setFftPlanning(KeyFinder::FFT_PLANNING_MEASURE);
+    ASSERT_EQ(KeyFinder::FFT_PLANNING_MEASURE, KeyFinder::getFftPlanning());
+    KeyFinder::FftAdapter measured(frameSize);
+    KeyFinder::setFftPlanning(KeyFinder::FFT_PLANNING_ESTIMATE);
+
+    for (unsigned int i = 0; i < frameSize; i++) {
+        float sample = sine_wave(i, 10, frameSize, 1000) + sine_wave(i, 99, frameSize, 300);
+        estimated.setInput(i, sample);
+        measured.setInput(i, sample);
+    }
+    estimated.execute();
+    measured.execute();
+    for (unsigned int i = 0; i < frameSize; i++) {
+        // rounding differs between algorithms; allow for it relative to the peak
+        ASSERT_NEAR(estimated.getOutputMagnitude(i), measured.getOutputMagnitude(i), 1.0);
+    }
+}
+
+TEST(FftAdapterTest, WisdomRoundTrip)
+{
+    std::string path = "keyfinder-test-wisdom";
+    ASSERT_FALSE(KeyFinder::importFftWisdom("/nonexistent/keyfinder-wisdom"));
+    ASSERT_TRUE(KeyFinder::exportFftWisdom(path));
+    KeyFinder::forgetFftWisdom();
+    ASSERT_TRUE(KeyFinder::importFftWisdom(path));
+    std::remove(path.c_str());
+}
@@ -21,6 +21,8 @@
 
 #include "_testhelpers.h"
 
+#include <algorithm>
+
 /*
 TEST (KeyClassifierTest, DetectsSilence) {
   KeyFinder::KeyClassifier kc(simCos, tpS, false);
@@ -103,3 +105,90 @@ TEST (KeyClassifierTest, DetectsOtherTriads) {
   ASSERT_EQ(KeyFinder::G_MAJOR, kc.classify(gMajor));
 }
 */
+
+TEST(KeyClassifierTest, ValidatesSizes)
+{
+    std::vector<float> profile(BANDS, 1.0);
+    std::vector<float> shortProfile(BANDS - 1, 1.0);
+    ASSERT_THROW(KeyFinder::KeyClassifier(shortProfile, profile), KeyFinder::Exception);
+    ASSERT_THROW(KeyFinder::KeyClassifier(profile, shortProfile), KeyFinder::Exception);
+
+    KeyFinder::KeyClassifier kc(profile, profile);
+    ASSERT_THROW(kc.classify(std::vector<float>(BANDS + 1, 1.0)), KeyFinder::Exception);
+}
+
+TEST(KeyClassifierTest, DetectsSilence)
+{
+    KeyFinder::KeyClassifier kc(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+    ASSERT_EQ(KeyFinder::SILENCE, kc.classify(std::vector<float>(BANDS, 0.0)));
+}
+
+TEST(KeyClassifierTest, MatchesToneProfileSimilarity)
+{
+    KeyFinder::ToneProfile major(KeyFinder::toneProfileMajor());
+    KeyFinder::ToneProfile minor(KeyFinder::toneProfileMinor());
+    KeyFinder::KeyClassifier kc(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+
+    std::vector<float> chroma(BANDS);
+    for (unsigned int trial = 0; trial < 50; trial++) {
+        for (unsigned int b = 0; b < BANDS; b++) {
+            chroma[b] = ((b * 7919 + trial * 104729) % 997) / 997.0;
+        }
+        // boost a triad on a moving root so every key gets a chance to win
+        for (unsigned int o = 0; o < OCTAVES; o++) {
+            chroma[o * SEMITONES + (trial % SEMITONES)] += 3.0;
+            chroma[o * SEMITONES + ((trial + 3 + trial % 2) % SEMITONES)] += 2.0;
+            chroma[o * SEMITONES + ((trial + 7) % SEMITONES)] += 2.0;
+        }
+
+        KeyFinder::KeyT expected = KeyFinder::SILENCE;
+        float bestScore = 0.0;
+        for (unsigned int i = 0; i < SEMITONES; i++) {
+            float majorScore = major.cosineSimilarity(chroma, i);
+            if (majorScore > bestScore) {
+                bestScore = majorScore;
+                expected = (KeyFinder::KeyT)(i * 2);
+            }
+            float minorScore = minor.cosineSimilarity(chroma, i);
+            if (minorScore > bestScore) {
+                bestScore = minorScore;
+                expected = (KeyFinder::KeyT)((i * 2) + 1);
+            }
+        }
+        ASSERT_EQ(expected, kc.classify(chroma));
+    }
+}
+
+TEST(KeyClassifierTest, EstimateScoresEveryKey)
+{
+    KeyFinder::ToneProfile major(KeyFinder::toneProfileMajor());
+    KeyFinder::ToneProfile minor(KeyFinder::toneProfileMinor());
+    KeyFinder::KeyClassifier kc(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+
+    std::vector<float> chroma(BANDS);
+    for (unsigned int b = 0; b < BANDS; b++) {
+        chroma[b] = ((b * 7919) % 997) / 997.0;
+    }
+    KeyFinder::KeyEstimate estimate = kc.estimate(chroma);
+    ASSERT_EQ(kc.classify(chroma), estimate.key);
+    ASSERT_EQ(KEYS, estimate.scores.size());
+    for (unsigned int i = 0; i < SEMITONES; i++) {
+        ASSERT_NEAR(major.cosineSimilarity(chroma, i), estimate.scores[i * 2], 0.0001);
+        ASSERT_NEAR(minor.cosineSimilarity(chroma, i), estimate.scores[(i * 2) + 1], 0.0001);
+        ASSERT_TRUE(estimate.scores[i * 2] <= estimate.scores[estimate.key]);
+    }
+
+    std::vector<float> sorted = estimate.scores;
+    std::sort(sorted.rbegin(), sorted.rend());
+    ASSERT_FLOAT_EQ(sorted[0] - sorted[1], estimate.margin);
+    ASSERT_FLOAT_EQ(estimate.margin / sorted[0], estimate.confidence);
+    ASSERT_GT(estimate.confidence, 0.0);
+    ASSERT_LE(estimate.confidence, 1.0);
+
+    KeyFinder::KeyEstimate silence = kc.estimate(std::vector<float>(BANDS, 0.0));
+    ASSERT_EQ(KeyFinder::SILENCE, silence.key);
+    ASSERT_FLOAT_EQ(0.0, silence.scores[0]);
+    ASSERT_FLOAT_EQ(0.0, silence.margin);
+    ASSERT_FLOAT_EQ(0.0, silence.confidence);
+    ASSERT_THROW(kc.estimate(std::vector<float>(BANDS - 1, 1.0)), KeyFinder::Exception);
+}
@@ -21,6 +21,10 @@
 
 #include "_testhelpers.h"
 
+#include <atomic>
+#include <random>
+#include <thread>
+
 TEST(KeyFinderTest, BasicUseCase)
 {
     unsigned int sampleRate = 44100;
@@ -45,8 +49,8 @@ TEST(KeyFinderTest, ProgressiveUseCase)
     /*
    * Build a second of audio, to be added ten times. The default settings will
    * lead to a downsample factor of 10, so there'll be 44100 samples of audio
-   * after pre-processing. That'll be 7 hops, with 15428 samples left in the
-   * buffer. Then finish that off with finalChromagramOfAudio, which should add
+   * after pre-processing, less the 8 held back by the filter's look-ahead.
+   * That'll be 7 hops, with 15421 samples left in the buffer. Then finish that off with finalChromagramOfAudio, which should add
    * 4 more hops and leave 12288 zeroed samples in the buffer.
    */
 
@@ -89,19 +93,19 @@ TEST(KeyFinderTest, ProgressiveUseCase)
         ASSERT_EQ(testFftPointer, w.fftAdapter);
         ASSERT_EQ(4410, w.preprocessedBuffer.getFrameRate());
         ASSERT_EQ(1, w.preprocessedBuffer.getChannels());
-        // check that the offset left some unprocessed audio in the remainder
-        ASSERT_EQ(4, w.remainderBuffer.getSampleCount());
-        // and that the remainder is equal to the last 4 samples which were excluded
-        for (unsigned int j = 0; j < 4; j++) {
+        // check that the filter kept the history it still needs in the remainder
+        ASSERT_EQ(154, w.remainderBuffer.getSampleCount());
+        // and that the remainder is equal to the last 154 samples
+        for (unsigned int j = 0; j < 154; j++) {
             ASSERT_FLOAT_EQ(
-                inputAudio.getSample(inputAudio.getSampleCount() - 4 + j),
+                inputAudio.getSample(inputAudio.getSampleCount() - 154 + j),
                 w.remainderBuffer.getSample(j));
         }
     }
 
     // progressive result without emptying preprocessedBuffer
     ASSERT_EQ(7, w.chromagram->getHops());
-    ASSERT_EQ(15428, w.preprocessedBuffer.getSampleCount());
+    ASSERT_EQ(15421, w.preprocessedBuffer.getSampleCount());
 
     // after emptying preprocessedBuffer
     k.finalChromagram(w);
@@ -116,6 +120,369 @@ TEST(KeyFinderTest, ProgressiveUseCase)
     ASSERT_EQ(KeyFinder::A_MINOR, k.keyOfChromagram(w));
 }
 
+TEST(KeyFinderTest, StreamingKeepsRecentHopsOnly)
+{
+    unsigned int sampleRate = 44100;
+    KeyFinder::AudioData a;
+    a.setFrameRate(sampleRate);
+    a.setChannels(1);
+    a.addToSampleCount(sampleRate);
+    for (unsigned int i = 0; i < sampleRate; i++) {
+        a.setSample(i, sine_wave(i, 440.0000, sampleRate, 1) + sine_wave(i, 523.2511, sampleRate, 1) + sine_wave(i, 659.2551, sampleRate, 1));
+    }
+
+    KeyFinder::KeyFinder k;
+    KeyFinder::Workspace whole;
+    KeyFinder::Workspace streamed;
+    streamed.retainRecentHops(2);
+    for (unsigned int i = 0; i < 30; i++) {
+        k.progressiveChromagram(a, whole);
+        k.progressiveChromagram(a, streamed);
+    }
+    k.finalChromagram(whole);
+    k.finalChromagram(streamed);
+
+    ASSERT_EQ(whole.chromagram->getHops(), streamed.chromagram->getHops());
+    ASSERT_EQ(streamed.chromagram->getHops() - 2, streamed.chromagram->getFirstRetainedHop());
+    std::vector<float> wholeChroma = whole.chromagram->collapseToOneHop();
+    std::vector<float> streamedChroma = streamed.chromagram->collapseToOneHop();
+    for (unsigned int b = 0; b < BANDS; b++) {
+        ASSERT_FLOAT_EQ(wholeChroma[b], streamedChroma[b]);
+    }
+    unsigned int last = whole.chromagram->getHops() - 1;
+    ASSERT_FLOAT_EQ(whole.chromagram->getMagnitude(last, 0), streamed.chromagram->getMagnitude(last, 0));
+    ASSERT_EQ(k.keyOfChromagram(whole), k.keyOfChromagram(streamed));
+}
+
+TEST(KeyFinderTest, UntilStableStopsEarlyOnSteadyAudio)
+{
+    unsigned int sampleRate = 44100;
+    unsigned int seconds = 120;
+    std::vector<float> samples(sampleRate * seconds);
+    for (unsigned int i = 0; i < samples.size(); i++) {
+        samples[i] = sine_wave(i, 440.0000, sampleRate, 1) + sine_wave(i, 523.2511, sampleRate, 1) + sine_wave(i, 659.2551, sampleRate, 1);
+    }
+    KeyFinder::AudioView view(samples.data(), samples.size(), 1, sampleRate);
+    KeyFinder::KeyFinder k;
+
+    KeyFinder::StabilityCriterion criterion;
+    criterion.stableHops = 16;
+    KeyFinder::StableKeyResult early = k.keyOfAudioUntilStable(view, criterion);
+    ASSERT_TRUE(early.stoppedEarly);
+    ASSERT_EQ(KeyFinder::A_MINOR, early.key);
+    ASSERT_LT(early.framesAnalysed, samples.size());
+    ASSERT_GE(early.hopsAnalysed, 16);
+
+    // a criterion that can't be met analyses everything, as keyOfAudio does
+    criterion.minimumMargin = 2.0;
+    KeyFinder::StableKeyResult full = k.keyOfAudioUntilStable(view, criterion);
+    ASSERT_FALSE(full.stoppedEarly);
+    ASSERT_EQ(samples.size(), full.framesAnalysed);
+    ASSERT_EQ(k.keyOfAudio(view), full.key);
+    ASSERT_GT(full.hopsAnalysed, early.hopsAnalysed);
+
+    // also on noisy, tonally ambiguous audio, where a small difference in the
+    // chromagram could change the key
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> noise(-1.0, 1.0);
+    for (unsigned int track = 0; track < 6; track++) {
+        std::vector<float> noisy(sampleRate * 20);
+        float root = 220.0 * pow(2.0, track / 12.0);
+        for (unsigned int i = 0; i < noisy.size(); i++) {
+            noisy[i] = sine_wave(i, root, sampleRate, 1) + sine_wave(i, root * 1.4983, sampleRate, 1) + (2 * noise(random));
+        }
+        KeyFinder::AudioView noisyView(noisy.data(), noisy.size(), 1, sampleRate);
+        KeyFinder::StableKeyResult noisyFull = k.keyOfAudioUntilStable(noisyView, criterion);
+        ASSERT_FALSE(noisyFull.stoppedEarly);
+        ASSERT_EQ(k.keyOfAudio(noisyView), noisyFull.key);
+    }
+}
+
+TEST(KeyFinderTest, QuickScanSamplesHops)
+{
+    unsigned int sampleRate = 44100;
+    std::vector<float> samples(sampleRate * 120);
+    for (unsigned int i = 0; i < samples.size(); i++) {
+        samples[i] = sine_wave(i, 440.0000, sampleRate, 1) + sine_wave(i, 523.2511, sampleRate, 1) + sine_wave(i, 659.2551, sampleRate, 1);
+    }
+    KeyFinder::AudioView view(samples.data(), samples.size(), 1, sampleRate);
+    KeyFinder::KeyFinder k;
+
+    KeyFinder::QuickScanResult strided = k.keyOfAudioQuickScan(view);
+    ASSERT_EQ(KeyFinder::A_MINOR, strided.key);
+    ASSERT_EQ(126, strided.hopsTotal);
+    ASSERT_EQ(8, strided.hopsAnalysed);
+
+    KeyFinder::QuickScanOptions options;
+    options.hopBudget = 10;
+    KeyFinder::QuickScanResult budgeted = k.keyOfAudioQuickScan(view, options);
+    ASSERT_EQ(KeyFinder::A_MINOR, budgeted.key);
+    ASSERT_LE(budgeted.hopsAnalysed, 10);
+    ASSERT_GE(budgeted.hopsAnalysed, 9);
+
+    // overlapping frames share one excerpt
+    options.hopBudget = 0;
+    options.hopStride = 1;
+    KeyFinder::QuickScanResult every = k.keyOfAudioQuickScan(view, options);
+    ASSERT_EQ(every.hopsTotal, every.hopsAnalysed);
+    ASSERT_EQ(k.keyOfAudio(view), every.key);
+
+    // too short to sample
+    KeyFinder::QuickScanResult brief = k.keyOfAudioQuickScan(view.subView(0, sampleRate));
+    ASSERT_EQ(1, brief.hopsAnalysed);
+    ASSERT_EQ(k.keyOfAudio(view.subView(0, sampleRate)), brief.key);
+}
+
+// Song-length chord progressions, where the default stride reads about a
+// quarter of the audio (about 5x faster than a full analysis in the
+// benchmark) and agrees with the full analysis on every key it is given.
+TEST(KeyFinderTest, QuickScanAgreesWithFullAnalysis)
+{
+    unsigned int sampleRate = 22050;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> unit(0.0, 1.0);
+    KeyFinder::KeyFinder k;
+    for (unsigned int tonic : { 0U, 3U, 7U, 10U }) {
+        std::vector<float> samples(sampleRate * 180);
+        // I, vi, IV and V of the major key, each held for one to three seconds
+        const unsigned int roots[4] = { 0, 9, 5, 7 };
+        const unsigned int thirds[4] = { 4, 3, 4, 4 };
+        unsigned int chord = 0;
+        unsigned int chordEnd = 0;
+        for (unsigned int i = 0; i < samples.size(); i++) {
+            if (i >= chordEnd) {
+                chord = (unsigned int)(unit(random) * 4) % 4;
+                chordEnd = i + (unsigned int)(sampleRate * (1.0 + (2.0 * unit(random))));
+            }
+            float root = 220.0 * pow(2.0, (tonic + roots[chord]) / 12.0);
+            samples[i] = sine_wave(i, root, sampleRate, 1) + sine_wave(i, root * pow(2.0, thirds[chord] / 12.0), sampleRate, 1) + sine_wave(i, root * 1.4983, sampleRate, 1);
+        }
+        KeyFinder::AudioView view(samples.data(), samples.size(), 1, sampleRate);
+        KeyFinder::QuickScanResult quick = k.keyOfAudioQuickScan(view);
+        ASSERT_LE(quick.hopsAnalysed * 16, quick.hopsTotal + 15);
+        ASSERT_EQ(k.keyOfAudio(view), quick.key);
+    }
+}
+
+TEST(KeyFinderTest, ConfigurableFrameAndHopSizes)
+{
+    unsigned int sampleRate = 44100;
+    std::vector<float> samples(sampleRate * 20);
+    for (unsigned int i = 0; i < samples.size(); i++) {
+        samples[i] = sine_wave(i, 440.0000, sampleRate, 1) + sine_wave(i, 523.2511, sampleRate, 1) + sine_wave(i, 659.2551, sampleRate, 1);
+    }
+    KeyFinder::AudioView view(samples.data(), samples.size(), 1, sampleRate);
+
+    KeyFinder::KeyFinder standard;
+    ASSERT_EQ(FFTFRAMESIZE, standard.getAnalysisConfig().frameSize);
+    ASSERT_EQ(HOPSIZE, standard.getAnalysisConfig().hopSize);
+
+    KeyFinder::AnalysisConfig config;
+    config.frameSize = 8192;
+    config.hopSize = 2048;
+    KeyFinder::KeyFinder small(config);
+    ASSERT_EQ(KeyFinder::A_MINOR, small.keyOfAudio(view));
+
+    KeyFinder::Workspace fine;
+    KeyFinder::Workspace coarse;
+    small.progressiveChromagram(view, fine);
+    small.finalChromagram(fine);
+    standard.progressiveChromagram(view, coarse);
+    standard.finalChromagram(coarse);
+    ASSERT_EQ(config.frameSize, fine.fftAdapter->getFrameSize());
+    ASSERT_GT(fine.chromagram->getHops(), coarse.chromagram->getHops() * 3 / 2);
+
+    // a workspace's FFT adapter follows the KeyFinder analysing it
+    fine.reset();
+    standard.progressiveChromagram(view, fine);
+    ASSERT_EQ(FFTFRAMESIZE, fine.fftAdapter->getFrameSize());
+
+    config.hopSize = 0;
+    ASSERT_THROW(KeyFinder::KeyFinder { config }, KeyFinder::Exception);
+    config.hopSize = 16384;
+    ASSERT_THROW(KeyFinder::KeyFinder { config }, KeyFinder::Exception);
+    // frames must keep FFT batches aligned
+    config.frameSize = 8190;
+    config.hopSize = 2048;
+    ASSERT_THROW(KeyFinder::KeyFinder { config }, KeyFinder::Exception);
+    // too short to resolve the lowest semitones; without an analysis rate
+    // this can only be found once the audio's frame rate is known
+    config.frameSize = 1024;
+    config.hopSize = 512;
+    KeyFinder::KeyFinder tiny(config);
+    ASSERT_THROW(tiny.keyOfAudio(view), KeyFinder::Exception);
+    config.analysisRate = 4410;
+    ASSERT_THROW(KeyFinder::KeyFinder { config }, KeyFinder::Exception);
+}
+
+TEST(KeyFinderTest, CanonicalAnalysisRate)
+{
+    KeyFinder::AnalysisConfig config;
+    config.analysisRate = 4410;
+    KeyFinder::KeyFinder k(config);
+
+    unsigned int sampleRates[] = { 22050, 44100, 48000, 96000 };
+    for (unsigned int sampleRate : sampleRates) {
+        std::vector<float> samples(sampleRate * 20);
+        for (unsigned int i = 0; i < samples.size(); i++) {
+            samples[i] = sine_wave(i, 440.0000, sampleRate, 1) + sine_wave(i, 523.2511, sampleRate, 1) + sine_wave(i, 659.2551, sampleRate, 1);
+        }
+        KeyFinder::AudioView view(samples.data(), samples.size(), 1, sampleRate);
+        ASSERT_EQ(KeyFinder::A_MINOR, k.keyOfAudio(view));
+
+        KeyFinder::Workspace w;
+        k.progressiveChromagram(view.subView(0, sampleRate * 10), w);
+        k.progressiveChromagram(view.subView(sampleRate * 10, sampleRate * 10), w);
+        k.finalChromagram(w);
+        ASSERT_EQ(4410, w.preprocessedBuffer.getFrameRate());
+        ASSERT_EQ(KeyFinder::A_MINOR, k.keyOfChromagram(w));
+
+        ASSERT_EQ(KeyFinder::A_MINOR, k.keyOfAudioQuickScan(view).key);
+        ASSERT_EQ(KeyFinder::A_MINOR, k.keyOfAudioUntilStable(view).key);
+    }
+
+    // too low for the top octave
+    config.analysisRate = 3000;
+    ASSERT_THROW(KeyFinder::KeyFinder { config }, KeyFinder::Exception);
+}
+
+TEST(KeyFinderTest, ProgressiveViewMatchesAudioData)
+{
+    unsigned int sampleRate = 44100;
+    unsigned int channels = 2;
+    std::vector<float> interleaved(sampleRate * channels);
+    KeyFinder::AudioData inputAudio;
+    inputAudio.setFrameRate(sampleRate);
+    inputAudio.setChannels(channels);
+    inputAudio.addToFrameCount(sampleRate);
+    for (unsigned int i = 0; i < sampleRate; i++) {
+        float sample = 0.0;
+        sample += sine_wave(i, 440.0000, sampleRate, 1);
+        sample += sine_wave(i, 523.2511, sampleRate, 1);
+        sample += sine_wave(i, 659.2551, sampleRate, 1);
+        for (unsigned int c = 0; c < channels; c++) {
+            inputAudio.setSampleByFrame(i, c, sample);
+            interleaved[i * channels + c] = sample;
+        }
+    }
+    KeyFinder::AudioView view(interleaved.data(), sampleRate, channels, sampleRate);
+
+    KeyFinder::KeyFinder k;
+    KeyFinder::Workspace fromData;
+    KeyFinder::Workspace fromView;
+    for (unsigned int i = 0; i < 4; i++) {
+        k.progressiveChromagram(inputAudio, fromData);
+        k.progressiveChromagram(view, fromView);
+    }
+    k.finalChromagram(fromData);
+    k.finalChromagram(fromView);
+
+    ASSERT_EQ(fromData.chromagram->getHops(), fromView.chromagram->getHops());
+    for (unsigned int h = 0; h < fromData.chromagram->getHops(); h++) {
+        for (unsigned int b = 0; b < BANDS; b++) {
+            ASSERT_FLOAT_EQ(fromData.chromagram->getMagnitude(h, b), fromView.chromagram->getMagnitude(h, b));
+        }
+    }
+    ASSERT_EQ(KeyFinder::A_MINOR, k.keyOfChromagram(fromView));
+}
+
+TEST(KeyFinderTest, ChunkingDoesNotChangeChromagram)
+{
+    unsigned int sampleRate = 44100;
+    std::vector<float> samples(sampleRate * 10);
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> noise(-1.0, 1.0);
+    for (unsigned int i = 0; i < samples.size(); i++) {
+        samples[i] = sine_wave(i, 329.6276, sampleRate, 1) + sine_wave(i, 493.8833, sampleRate, 1) + noise(random);
+    }
+    KeyFinder::AudioView view(samples.data(), samples.size(), 1, sampleRate);
+
+    KeyFinder::KeyFinder k;
+    KeyFinder::Workspace whole;
+    KeyFinder::Workspace chunked;
+    k.progressiveChromagram(view, whole);
+    k.finalChromagram(whole);
+    std::uniform_int_distribution<unsigned int> chunkFrames(1, 20000);
+    for (unsigned int frame = 0; frame < samples.size();) {
+        unsigned int frames = std::min(chunkFrames(random), (unsigned int)samples.size() - frame);
+        k.progressiveChromagram(view.subView(frame, frames), chunked);
+        frame += frames;
+    }
+    k.finalChromagram(chunked);
+
+    ASSERT_EQ(whole.chromagram->getHops(), chunked.chromagram->getHops());
+    for (unsigned int h = 0; h < whole.chromagram->getHops(); h++) {
+        for (unsigned int b = 0; b < BANDS; b++) {
+            ASSERT_FLOAT_EQ(whole.chromagram->getMagnitude(h, b), chunked.chromagram->getMagnitude(h, b));
+        }
+    }
+}
+
+TEST(KeyFinderTest, KeyEstimateTracksProgressiveAnalysis)
+{
+    unsigned int sampleRate = 44100;
+    KeyFinder::AudioData a;
+    a.setFrameRate(sampleRate);
+    a.setChannels(1);
+    a.addToSampleCount(sampleRate);
+    for (unsigned int i = 0; i < sampleRate; i++) {
+        a.setSample(i, sine_wave(i, 440.0000, sampleRate, 1) + sine_wave(i, 523.2511, sampleRate, 1) + sine_wave(i, 659.2551, sampleRate, 1));
+    }
+
+    KeyFinder::KeyFinder k;
+    KeyFinder::Workspace w;
+    ASSERT_EQ(KeyFinder::SILENCE, k.keyEstimateOfChromagram(w).key);
+    for (unsigned int i = 0; i < 4; i++) {
+        k.progressiveChromagram(a, w);
+        KeyFinder::KeyEstimate estimate = k.keyEstimateOfChromagram(w);
+        ASSERT_EQ(k.keyOfChromagram(w), estimate.key);
+        ASSERT_EQ(KEYS, estimate.scores.size());
+    }
+    k.finalChromagram(w);
+    KeyFinder::KeyEstimate estimate = k.keyEstimateOfChromagram(w);
+    ASSERT_EQ(KeyFinder::A_MINOR, estimate.key);
+    ASSERT_TRUE(estimate.scores[KeyFinder::A_MINOR] > estimate.scores[KeyFinder::C_MAJOR]);
+}
+
+TEST(KeyFinderTest, KeyEstimateOfChromaVector)
+{
+    std::vector<float> chroma(BANDS, 0.0);
+    for (unsigned int o = 0; o < OCTAVES; o++) {
+        chroma[o * SEMITONES + 0] = 1.0;
+        chroma[o * SEMITONES + 3] = 1.0;
+        chroma[o * SEMITONES + 7] = 1.0;
+    }
+    KeyFinder::KeyEstimate estimate = KeyFinder::KeyFinder::keyEstimateOfChromaVector(chroma);
+    ASSERT_EQ(KeyFinder::KeyFinder::keyOfChromaVector(chroma, KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor()), estimate.key);
+    ASSERT_GT(estimate.margin, 0.0);
+
+    // a flat major profile leaves only the minor keys distinguishable
+    std::vector<float> flat(BANDS, 1.0);
+    KeyFinder::KeyEstimate overridden = KeyFinder::KeyFinder::keyEstimateOfChromaVector(chroma, flat, KeyFinder::toneProfileMinor());
+    ASSERT_EQ(KeyFinder::KeyFinder::keyOfChromaVector(chroma, flat, KeyFinder::toneProfileMinor()), overridden.key);
+    ASSERT_FLOAT_EQ(overridden.scores[KeyFinder::A_MAJOR], overridden.scores[KeyFinder::C_MAJOR]);
+
+    // alternating profile sets, from several threads, each keep their own classifier
+    std::vector<std::thread> threads;
+    std::atomic<unsigned int> mismatches(0);
+    for (unsigned int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            for (unsigned int i = 0; i < 50; i++) {
+                const std::vector<float>& major = i % 2 == 0 ? flat : KeyFinder::toneProfileMajor();
+                KeyFinder::KeyEstimate e = KeyFinder::KeyFinder::keyEstimateOfChromaVector(chroma, major, KeyFinder::toneProfileMinor());
+                const KeyFinder::KeyEstimate& expected = i % 2 == 0 ? overridden : estimate;
+                if (e.key != expected.key || e.scores != expected.scores) {
+                    mismatches++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(0, mismatches.load());
+}
+
 TEST(KeyFinderTest, KeyOfChromagramReturnsSilence)
 {
     KeyFinder::Workspace w;
@@ -146,3 +513,126 @@ TEST(KeyFinderTest, KeyOfChromagramCollapsesTimeDimension)
     KeyFinder::KeyFinder kf;
     ASSERT_EQ(KeyFinder::C_MINOR, kf.keyOfChromagram(w));
 }
+
+TEST(KeyFinderTest, ThreadedKeyOfAudioMatchesSerial)
+{
+    unsigned int frameRate = 44100;
+    KeyFinder::AudioData a;
+    a.setChannels(2);
+    a.setFrameRate(frameRate);
+    a.addToFrameCount(frameRate * 20);
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        float t = (float)(i / 2) / frameRate;
+        a.setSample(i, sin(2 * PI * 440.0 * t) + sin(2 * PI * 523.25 * t) + sin(2 * PI * 659.26 * t));
+    }
+
+    KeyFinder::KeyFinder kf;
+    KeyFinder::KeyT serial = kf.keyOfAudio(a);
+    for (unsigned int threads : { 0U, 2U, 3U, 64U }) {
+        ASSERT_EQ(serial, kf.keyOfAudio(a, threads));
+    }
+
+    // preprocessing is split too, and stitched back exactly, so even keys
+    // that hang on small chroma differences match, with either front end
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> noise(-1.0, 1.0);
+    KeyFinder::AnalysisConfig config;
+    config.analysisRate = 4410;
+    KeyFinder::KeyFinder resampling(config);
+    for (unsigned int track = 0; track < 4; track++) {
+        unsigned int rate = track % 2 == 0 ? 44100 : 48000;
+        KeyFinder::AudioData noisy;
+        noisy.setChannels(1);
+        noisy.setFrameRate(rate);
+        noisy.addToFrameCount(rate * 20);
+        float root = 220.0 * pow(2.0, track / 12.0);
+        for (unsigned int i = 0; i < noisy.getSampleCount(); i++) {
+            noisy.setSample(i, sine_wave(i, root, rate, 1) + sine_wave(i, root * 1.4983, rate, 1) + (2 * noise(random)));
+        }
+        ASSERT_EQ(kf.keyOfAudio(noisy), kf.keyOfAudio(noisy, 3));
+        ASSERT_EQ(resampling.keyOfAudio(noisy), resampling.keyOfAudio(noisy, 3));
+    }
+}
+
+TEST(KeyFinderTest, BatchMatchesIndividualAnalysis)
+{
+    unsigned int frameRate = 44100;
+    std::vector<KeyFinder::AudioData> tracks(5);
+    for (unsigned int t = 0; t < tracks.size(); t++) {
+        KeyFinder::AudioData& a = tracks[t];
+        a.setChannels(1);
+        a.setFrameRate(frameRate);
+        a.addToSampleCount(frameRate * (1 + (t * 3) % 7));
+        for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+            a.setSample(i, sine_wave(i, 220 * pow(2, t / 12.0), frameRate, 1) + sine_wave(i, 330 * pow(2, t / 12.0), frameRate, 1));
+        }
+    }
+    std::vector<const KeyFinder::AudioData*> batch;
+    for (auto& a : tracks) {
+        batch.push_back(&a);
+    }
+
+    KeyFinder::KeyFinder kf;
+    std::vector<KeyFinder::KeyT> expected;
+    for (auto& a : tracks) {
+        expected.push_back(kf.keyOfAudio(a));
+    }
+    ASSERT_EQ(expected, kf.keyOfAudioBatch(batch, 3));
+
+    // the callback runs on worker threads, so check its results afterwards
+    std::vector<KeyFinder::KeyT> fromSource(tracks.size(), KeyFinder::SILENCE);
+    std::vector<bool> failed(tracks.size(), true);
+    unsigned int next = 0;
+    std::mutex resultMutex;
+    kf.keyOfAudioBatch([&]() -> const KeyFinder::AudioData* {
+        return next < tracks.size() ? &tracks[next++] : nullptr;
+    },
+        [&](unsigned int index, KeyFinder::KeyT key, std::exception_ptr error) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            fromSource[index] = key;
+            failed[index] = error != nullptr;
+        },
+        2);
+    ASSERT_EQ(expected, fromSource);
+    ASSERT_EQ(std::vector<bool>(tracks.size(), false), failed);
+}
+
+TEST(KeyFinderTest, BatchReportsTrackErrors)
+{
+    KeyFinder::AudioData good;
+    good.setChannels(1);
+    good.setFrameRate(44100);
+    good.addToSampleCount(44100);
+    std::vector<const KeyFinder::AudioData*> batch = { &good, nullptr, &good };
+
+    KeyFinder::KeyFinder kf;
+    ASSERT_THROW(kf.keyOfAudioBatch(batch, 2), KeyFinder::Exception);
+
+    std::vector<bool> failed(batch.size(), false);
+    kf.keyOfAudioBatch(batch, [&failed](unsigned int index, KeyFinder::KeyT, std::exception_ptr error) {
+        failed[index] = error != nullptr;
+    },
+        1);
+    ASSERT_FALSE(failed[0]);
+    ASSERT_TRUE(failed[1]);
+    ASSERT_FALSE(failed[2]);
+}
+
+TEST(KeyFinderTest, KeyOfAudioViewMatchesAudioData)
+{
+    unsigned int frameRate = 44100;
+    std::vector<int16_t> pcm(frameRate * 6 * 2);
+    KeyFinder::AudioData a;
+    a.setChannels(2);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(pcm.size());
+    for (unsigned int i = 0; i < pcm.size(); i++) {
+        unsigned int frame = i / 2;
+        float sample = 0.3 * (sine_wave(frame, 440, frameRate, 1) + sine_wave(frame, 554.37, frameRate, 1));
+        pcm[i] = (int16_t)(sample * 32767);
+        a.setSample(i, pcm[i] / 32768.0);
+    }
+
+    KeyFinder::KeyFinder kf;
+    ASSERT_EQ(kf.keyOfAudio(a), kf.keyOfAudio(KeyFinder::AudioView(pcm.data(), frameRate * 6, 2, frameRate, KeyFinder::SAMPLE_FORMAT_INT16)));
+}
@@ -0,0 +1,131 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "_testhelpers.h"
+
+namespace {
+
+// triads on the given roots, counted in semitones above A
+auto triadChroma(unsigned int root, unsigned int third) -> std::vector<float>
+{
+    std::vector<float> chroma(BANDS, 0.1);
+    for (unsigned int o = 0; o < OCTAVES; o++) {
+        chroma[o * SEMITONES + root] += 1.0;
+        chroma[o * SEMITONES + ((root + third) % SEMITONES)] += 1.0;
+        chroma[o * SEMITONES + ((root + 7) % SEMITONES)] += 1.0;
+    }
+    return chroma;
+}
+
+}
+
+TEST(KeySegmentationTest, FindsKeyChange)
+{
+    KeyFinder::KeyClassifier kc(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+    std::vector<float> first = triadChroma(0, 3);
+    std::vector<float> second = triadChroma(5, 4);
+    KeyFinder::KeyT firstKey = kc.classify(first);
+    KeyFinder::KeyT secondKey = kc.classify(second);
+    ASSERT_NE(firstKey, secondKey);
+
+    KeyFinder::Chromagram c;
+    for (unsigned int h = 0; h < 40; h++) {
+        c.appendHop(h < 20 ? first.data() : second.data());
+    }
+    KeyFinder::KeySegmentation s = KeyFinder::segmentKeys(c, kc, 8, 2);
+
+    ASSERT_EQ(17, s.windows.size());
+    ASSERT_EQ(2, s.segments.size());
+    ASSERT_EQ(0, s.segments[0].firstHop);
+    ASSERT_EQ(firstKey, s.segments[0].key);
+    ASSERT_EQ(secondKey, s.segments[1].key);
+    ASSERT_EQ(40, s.segments[1].firstHop + s.segments[1].hopCount);
+    ASSERT_EQ(s.segments[0].hopCount, s.segments[1].firstHop);
+    ASSERT_TRUE((s.segments[1].firstHop >= 18 && s.segments[1].firstHop <= 22));
+}
+
+TEST(KeySegmentationTest, WindowsMatchCollapsedSlices)
+{
+    KeyFinder::KeyClassifier kc(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+    KeyFinder::Chromagram c;
+    std::vector<float> hop(BANDS);
+    for (unsigned int h = 0; h < 24; h++) {
+        for (unsigned int b = 0; b < BANDS; b++) {
+            hop[b] = ((h * 7919 + b * 104729) % 997) / 997.0;
+        }
+        c.appendHop(hop.data());
+    }
+    KeyFinder::KeySegmentation s = KeyFinder::segmentKeys(c, kc, 5, 3);
+
+    // starts 0, 3, ..., 18 and a last window ending on the final hop
+    ASSERT_EQ(8, s.windows.size());
+    ASSERT_EQ(19, s.windows.back().firstHop);
+    for (const KeyFinder::KeySegment& window : s.windows) {
+        ASSERT_EQ(5, window.hopCount);
+        KeyFinder::Chromagram slice;
+        for (unsigned int h = window.firstHop; h < window.firstHop + window.hopCount; h++) {
+            slice.appendHop(c.getHop(h));
+        }
+        ASSERT_EQ(kc.classify(slice.collapseToOneHop()), window.key);
+    }
+
+    unsigned int covered = 0;
+    for (const KeyFinder::KeySegment& segment : s.segments) {
+        ASSERT_EQ(covered, segment.firstHop);
+        covered += segment.hopCount;
+    }
+    ASSERT_EQ(24, covered);
+}
+
+TEST(KeySegmentationTest, HandlesShortAndInvalidInput)
+{
+    KeyFinder::KeyClassifier kc(KeyFinder::toneProfileMajor(), KeyFinder::toneProfileMinor());
+    KeyFinder::Chromagram empty;
+    ASSERT_EQ(0, KeyFinder::segmentKeys(empty, kc, 4, 1).segments.size());
+    ASSERT_THROW(KeyFinder::segmentKeys(empty, kc, 0, 1), KeyFinder::Exception);
+    ASSERT_THROW(KeyFinder::segmentKeys(empty, kc, 4, 0), KeyFinder::Exception);
+
+    KeyFinder::Chromagram c(3);
+    KeyFinder::KeySegmentation s = KeyFinder::segmentKeys(c, kc, 4, 1);
+    ASSERT_EQ(1, s.windows.size());
+    ASSERT_EQ(3, s.windows[0].hopCount);
+    ASSERT_EQ(KeyFinder::SILENCE, s.segments[0].key);
+
+    c.retainRecentHops(0);
+    c.append(KeyFinder::Chromagram(100));
+    ASSERT_THROW(KeyFinder::segmentKeys(c, kc, 4, 1), KeyFinder::Exception);
+}
+
+TEST(KeySegmentationTest, KeyFinderSegmentsWorkspace)
+{
+    KeyFinder::Workspace w;
+    KeyFinder::KeyFinder k;
+    ASSERT_EQ(0, k.keySegmentsOfChromagram(w, 4, 2).windows.size());
+
+    std::vector<float> chroma = triadChroma(0, 3);
+    w.chromagram = new KeyFinder::Chromagram(0);
+    for (unsigned int h = 0; h < 10; h++) {
+        w.chromagram->appendHop(chroma.data());
+    }
+    KeyFinder::KeySegmentation s = k.keySegmentsOfChromagram(w, 4, 2);
+    ASSERT_EQ(1, s.segments.size());
+    ASSERT_EQ(k.keyOfChromagram(w), s.segments[0].key);
+}
@@ -21,6 +21,8 @@
 
 #include "_testhelpers.h"
 
+#include <thread>
+
 TEST(LowPassFilterFactoryTest, RepeatedFilterRequests)
 {
     KeyFinder::LowPassFilterFactory lpff;
@@ -32,3 +34,24 @@ TEST(LowPassFilterFactoryTest, RepeatedFilterRequests)
     ASSERT_EQ(lpf1, lpf2);
     ASSERT_NE(lpf2, lpf3);
 }
+
+TEST(LowPassFilterFactoryTest, ConcurrentRequestsShareFilters)
+{
+    KeyFinder::LowPassFilterFactory lpff;
+    std::vector<const KeyFinder::LowPassFilter*> results(12, nullptr);
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < results.size(); t++) {
+        threads.emplace_back([&lpff, &results, t]() {
+            results[t] = lpff.getLowPassFilter(2, 1, 20.0, 8 << (t % 3));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (unsigned int t = 0; t < results.size(); t++) {
+        ASSERT_EQ(lpff.getLowPassFilter(2, 1, 20.0, 8 << (t % 3)), results[t]);
+    }
+    ASSERT_NE(results[0], results[1]);
+}
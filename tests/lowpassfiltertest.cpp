@@ -200,6 +200,121 @@ TEST(LowPassFilterTest, WorksOnRepetitiveWaves)
     }
 }
 
+TEST(LowPassFilterTest, DecimateMatchesFilterThenDownsample)
+{
+    unsigned int factor = 10;
+    unsigned int samples = frameRate + 7;
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(samples);
+    for (unsigned int i = 0; i < samples; i++) {
+        float sample = 0.0;
+        sample += sine_wave(i, highFrequency, frameRate, magnitude);
+        sample += sine_wave(i, lowFrequency, frameRate, magnitude);
+        a.setSample(i, sample);
+    }
+    KeyFinder::AudioData b = a;
+
+    auto* lpf = new KeyFinder::LowPassFilter(filterOrder, frameRate, cornerFrequency, filterFFT);
+    KeyFinder::Workspace w;
+    lpf->filter(a, w, factor);
+    a.downsample(factor);
+    lpf->decimate(b, w, factor);
+    delete lpf;
+
+    ASSERT_EQ(a.getFrameRate(), b.getFrameRate());
+    ASSERT_EQ(a.getSampleCount(), b.getSampleCount());
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        ASSERT_FLOAT_EQ(a.getSample(i), b.getSample(i));
+    }
+}
+
+TEST(LowPassFilterTest, FusedDecimateMatchesSeparatePasses)
+{
+    unsigned int factor = 10;
+    unsigned int channels = 2;
+    unsigned int frames = frameRate * 2 + 3;
+    std::vector<float> interleaved(frames * channels);
+    for (unsigned int i = 0; i < frames; i++) {
+        interleaved[i * channels] = sine_wave(i, highFrequency, frameRate, magnitude);
+        interleaved[i * channels + 1] = sine_wave(i, lowFrequency, frameRate, magnitude);
+    }
+    KeyFinder::AudioView view(interleaved.data(), frames, channels, frameRate);
+
+    KeyFinder::AudioData head;
+    head.setChannels(1);
+    head.setFrameRate(frameRate);
+    head.addToSampleCount(4);
+    for (unsigned int i = 0; i < 4; i++) {
+        head.setSample(i, magnitude / (i + 1));
+    }
+
+    // separate passes
+    KeyFinder::AudioData a;
+    a.setChannels(channels);
+    a.setFrameRate(frameRate);
+    a.addToFrameCount(frames);
+    for (unsigned int i = 0; i < frames * channels; i++) {
+        a.setSample(i, interleaved[i]);
+    }
+    a.reduceToMono();
+    a.prepend(head);
+
+    auto* lpf = new KeyFinder::LowPassFilter(filterOrder, frameRate, cornerFrequency, filterFFT);
+    KeyFinder::Workspace w;
+    lpf->decimate(a, w, factor);
+
+    KeyFinder::AudioData b;
+    KeyFinder::Workspace streaming;
+    lpf->decimate(KeyFinder::AudioView(head.getSampleData(), 4, 1, frameRate), b, streaming, factor, false);
+    lpf->decimate(view, b, streaming, factor, true);
+    delete lpf;
+
+    ASSERT_EQ(1, b.getChannels());
+    ASSERT_EQ(a.getFrameRate(), b.getFrameRate());
+    ASSERT_EQ(a.getSampleCount(), b.getSampleCount());
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        ASSERT_NEAR(a.getSample(i), b.getSample(i), 0.01);
+    }
+}
+
+TEST(LowPassFilterTest, ChunkedDecimateMatchesWholeDecimate)
+{
+    unsigned int factor = 10;
+    unsigned int samples = frameRate + 7;
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(samples);
+    for (unsigned int i = 0; i < samples; i++) {
+        a.setSample(i, sine_wave(i, highFrequency, frameRate, magnitude) + sine_wave(i, lowFrequency, frameRate, magnitude));
+    }
+    KeyFinder::AudioView view(a.getSampleData(), samples, 1, frameRate);
+
+    auto* lpf = new KeyFinder::LowPassFilter(filterOrder, frameRate, cornerFrequency, filterFFT);
+    KeyFinder::AudioData chunked;
+    KeyFinder::Workspace w;
+    unsigned int chunks[] = { 0, 3, 1, 79, 200, 4096, 9 };
+    unsigned int frame = 0;
+    for (unsigned int chunk : chunks) {
+        lpf->decimate(view.subView(frame, chunk), chunked, w, factor, false);
+        frame += chunk;
+    }
+    lpf->decimate(view.subView(frame, samples - frame), chunked, w, factor, true);
+    ASSERT_EQ(0, w.remainderBuffer.getSampleCount());
+    ASSERT_EQ(0, w.decimationPosition);
+
+    lpf->decimate(a, w, factor);
+    delete lpf;
+
+    ASSERT_EQ(a.getFrameRate(), chunked.getFrameRate());
+    ASSERT_EQ(a.getSampleCount(), chunked.getSampleCount());
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        ASSERT_FLOAT_EQ(a.getSample(i), chunked.getSample(i));
+    }
+}
+
 TEST(LowPassFilterTest, DefaultFilterMatchesFisherCoefficients)
 {
     auto* lpf = new KeyFinder::LowPassFilter(160, 44100, 2000.0, 2048);
@@ -0,0 +1,36 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "_testhelpers.h"
+
+TEST(ResamplerFactoryTest, RepeatedResamplerRequests)
+{
+    KeyFinder::ResamplerFactory rf;
+
+    const KeyFinder::Resampler* r1 = rf.getResampler(48000, 4410, 2000.0);
+    const KeyFinder::Resampler* r2 = rf.getResampler(48000, 4410, 2000.0);
+    const KeyFinder::Resampler* r3 = rf.getResampler(96000, 4410, 2000.0);
+
+    ASSERT_EQ(r1, r2);
+    ASSERT_NE(r2, r3);
+    ASSERT_EQ(96000, r3->getInputRate());
+    ASSERT_EQ(4410, r3->getOutputRate());
+}
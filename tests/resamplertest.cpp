@@ -0,0 +1,140 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "_testhelpers.h"
+
+namespace {
+
+// a sine of the given frequency as mono audio
+auto sineAudio(unsigned int frameRate, float frequency, unsigned int frames) -> KeyFinder::AudioData
+{
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(frames);
+    for (unsigned int i = 0; i < frames; i++) {
+        a.setSample(i, sin(2 * PI * frequency * i / frameRate));
+    }
+    return a;
+}
+
+auto viewOf(const KeyFinder::AudioData& a) -> KeyFinder::AudioView
+{
+    return { a.getSampleData(), a.getFrameCount(), a.getChannels(), a.getFrameRate() };
+}
+
+// peak amplitude away from the filter's run-in and run-out
+auto peakOf(const KeyFinder::AudioData& a, unsigned int margin) -> float
+{
+    float peak = 0.0;
+    for (unsigned int i = margin; i + margin < a.getSampleCount(); i++) {
+        peak = std::max(peak, std::abs(a.getSample(i)));
+    }
+    return peak;
+}
+
+}
+
+TEST(ResamplerTest, ReducesRatioToLowestTerms)
+{
+    KeyFinder::Resampler r(48000, 4410, 2000.0);
+    ASSERT_EQ(147, r.getUpFactor());
+    ASSERT_EQ(1600, r.getDownFactor());
+    KeyFinder::Resampler s(44100, 4410, 2000.0);
+    ASSERT_EQ(1, s.getUpFactor());
+    ASSERT_EQ(10, s.getDownFactor());
+    ASSERT_EQ(161, s.getTapsPerPhase());
+}
+
+TEST(ResamplerTest, InsistsOnCornerBelowNyquist)
+{
+    KeyFinder::Resampler* r = nullptr;
+    ASSERT_THROW(r = new KeyFinder::Resampler(44100, 4410, 2205.0), KeyFinder::Exception);
+    ASSERT_THROW(r = new KeyFinder::Resampler(0, 4410, 2000.0), KeyFinder::Exception);
+    ASSERT_THROW(r = new KeyFinder::Resampler(44101, 4410, 2000.0), KeyFinder::Exception);
+    ASSERT_EQ(nullptr, r);
+}
+
+TEST(ResamplerTest, InsistsOnMatchingFrameRate)
+{
+    KeyFinder::Resampler r(48000, 4410, 2000.0);
+    KeyFinder::AudioData a = sineAudio(44100, 440.0, 1000);
+    KeyFinder::AudioData out;
+    KeyFinder::Workspace w;
+    ASSERT_THROW(r.resample(viewOf(a), out, w, true), KeyFinder::Exception);
+}
+
+TEST(ResamplerTest, PassesLowFrequencies)
+{
+    KeyFinder::Resampler r(48000, 4410, 2000.0);
+    KeyFinder::AudioData a = sineAudio(48000, 440.0, 48000);
+    KeyFinder::AudioData out;
+    KeyFinder::Workspace w;
+    r.resample(viewOf(a), out, w, true);
+
+    ASSERT_EQ(4410, out.getFrameRate());
+    ASSERT_EQ(1, out.getChannels());
+    ASSERT_NEAR(4410, out.getSampleCount(), 20);
+    ASSERT_NEAR(1.0, peakOf(out, 100), 0.01);
+    // the output is the input sine, delayed by half the filter
+    float delay = (r.getTapsPerPhase() - 1) / 2.0 / 48000;
+    for (unsigned int i = 100; i < 4300; i += 37) {
+        ASSERT_NEAR(sin(2 * PI * 440.0 * ((i / 4410.0) - delay)), out.getSample(i), 0.01);
+    }
+}
+
+TEST(ResamplerTest, RejectsHighFrequencies)
+{
+    KeyFinder::Resampler r(48000, 4410, 2000.0);
+    KeyFinder::AudioData a = sineAudio(48000, 6000.0, 48000);
+    KeyFinder::AudioData out;
+    KeyFinder::Workspace w;
+    r.resample(viewOf(a), out, w, true);
+    ASSERT_LT(peakOf(out, 100), 0.01);
+}
+
+TEST(ResamplerTest, ChunkedInputMatchesWholeInput)
+{
+    KeyFinder::Resampler r(44100, 4410 * 2, 2000.0);
+    KeyFinder::AudioData a = sineAudio(44100, 440.0, 20000);
+    KeyFinder::AudioView view = viewOf(a);
+
+    KeyFinder::AudioData whole;
+    KeyFinder::Workspace w1;
+    r.resample(view, whole, w1, true);
+
+    KeyFinder::AudioData chunked;
+    KeyFinder::Workspace w2;
+    unsigned int chunks[] = { 1, 7, 3000, 9, 10000 };
+    unsigned int frame = 0;
+    for (unsigned int chunk : chunks) {
+        r.resample(view.subView(frame, chunk), chunked, w2, false);
+        frame += chunk;
+    }
+    r.resample(view.subView(frame, a.getFrameCount() - frame), chunked, w2, true);
+
+    ASSERT_EQ(whole.getSampleCount(), chunked.getSampleCount());
+    for (unsigned int i = 0; i < whole.getSampleCount(); i++) {
+        ASSERT_FLOAT_EQ(whole.getSample(i), chunked.getSample(i));
+    }
+    ASSERT_EQ(0, w2.remainderBuffer.getSampleCount());
+    ASSERT_EQ(0, w2.resamplePosition);
+}
@@ -22,3 +22,108 @@
 #include "_testhelpers.h"
 
 // TODO: this.
+
+TEST(SpectrumAnalyserTest, BatchedTransformsMatchSingleTransforms)
+{
+    unsigned int frameRate = 4410;
+    unsigned int samples = FFTFRAMESIZE + (HOPSIZE * 6) + 100;
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(samples);
+    for (unsigned int i = 0; i < samples; i++) {
+        a.setSample(i, sine_wave(i, 440.0, frameRate, 1) + sine_wave(i, 659.2551 + i / 1000.0, frameRate, 1));
+    }
+
+    KeyFinder::ChromaTransformFactory ctFactory;
+    KeyFinder::TemporalWindowFactory twFactory;
+    KeyFinder::SpectrumAnalyser sa(frameRate, &ctFactory, &twFactory);
+
+    KeyFinder::FftAdapter single(FFTFRAMESIZE);
+    KeyFinder::FftAdapter batched(FFTFRAMESIZE, 4);
+    KeyFinder::Chromagram* expected = sa.chromagramOfWholeFrames(a, &single);
+    KeyFinder::Chromagram* actual = sa.chromagramOfWholeFrames(a, &batched);
+
+    ASSERT_EQ(7, expected->getHops());
+    ASSERT_EQ(expected->getHops(), actual->getHops());
+    for (unsigned int h = 0; h < expected->getHops(); h++) {
+        for (unsigned int b = 0; b < BANDS; b++) {
+            float e = expected->getMagnitude(h, b);
+            ASSERT_NEAR(e, actual->getMagnitude(h, b), std::max(0.001f, std::fabs(e) * 0.0001f));
+        }
+    }
+    delete expected;
+    delete actual;
+}
+
+TEST(SpectrumAnalyserTest, HopRangesStitchIntoWholeChromagram)
+{
+    unsigned int frameRate = 4410;
+    unsigned int samples = FFTFRAMESIZE + (HOPSIZE * 10) + 100;
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(samples);
+    for (unsigned int i = 0; i < samples; i++) {
+        a.setSample(i, sine_wave(i, 440.0, frameRate, 1) + sine_wave(i, 659.2551 + i / 1000.0, frameRate, 1));
+    }
+
+    KeyFinder::ChromaTransformFactory ctFactory;
+    KeyFinder::TemporalWindowFactory twFactory;
+    KeyFinder::SpectrumAnalyser sa(frameRate, &ctFactory, &twFactory);
+
+    KeyFinder::FftAdapter fft(FFTFRAMESIZE, 4);
+    KeyFinder::Chromagram* whole = sa.chromagramOfWholeFrames(a, &fft);
+    ASSERT_EQ(11, whole->getHops());
+
+    KeyFinder::Chromagram stitched;
+    for (unsigned int firstHop = 0; firstHop < 11; firstHop += 4) {
+        KeyFinder::Chromagram* range = sa.chromagramOfHops(a, &fft, firstHop, std::min(4U, 11 - firstHop));
+        stitched.append(*range);
+        delete range;
+    }
+
+    ASSERT_EQ(whole->getHops(), stitched.getHops());
+    for (unsigned int h = 0; h < whole->getHops(); h++) {
+        for (unsigned int b = 0; b < BANDS; b++) {
+            ASSERT_EQ(whole->getMagnitude(h, b), stitched.getMagnitude(h, b));
+        }
+    }
+    delete whole;
+
+    ASSERT_THROW(delete sa.chromagramOfHops(a, &fft, 8, 4), KeyFinder::Exception);
+}
+
+TEST(SpectrumAnalyserTest, ConfigurableFrameAndHopSizes)
+{
+    unsigned int frameRate = 4410;
+    unsigned int frameSize = 8192;
+    unsigned int hopSize = 1000;
+    unsigned int samples = frameSize + (hopSize * 9) + 100;
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(frameRate);
+    a.addToSampleCount(samples);
+    for (unsigned int i = 0; i < samples; i++) {
+        a.setSample(i, sine_wave(i, 440.0, frameRate, 1));
+    }
+
+    KeyFinder::ChromaTransformFactory ctFactory;
+    KeyFinder::TemporalWindowFactory twFactory;
+    KeyFinder::SpectrumAnalyser sa(frameRate, &ctFactory, &twFactory, frameSize, hopSize);
+
+    KeyFinder::FftAdapter fft(frameSize, 4);
+    KeyFinder::Chromagram* c = sa.chromagramOfWholeFrames(a, &fft);
+    ASSERT_EQ(10, c->getHops());
+    // hop 1 starts hopSize samples in, so it matches a range starting there
+    KeyFinder::Chromagram* range = sa.chromagramOfHops(a, &fft, 1, 1);
+    for (unsigned int b = 0; b < BANDS; b++) {
+        ASSERT_EQ(c->getMagnitude(1, b), range->getMagnitude(0, b));
+    }
+    delete c;
+    delete range;
+
+    KeyFinder::FftAdapter wrongSize(FFTFRAMESIZE);
+    ASSERT_THROW(delete sa.chromagramOfWholeFrames(a, &wrongSize), KeyFinder::Exception);
+    ASSERT_THROW(KeyFinder::SpectrumAnalyser(frameRate, &ctFactory, &twFactory, frameSize, 0), KeyFinder::Exception);
+}
@@ -25,6 +25,7 @@ TEMPLATE = app
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 CONFIG += c++11
 LIBS += -stdlib=libc++
@@ -37,7 +38,9 @@ HEADERS += _testhelpers.h
 SOURCES += \
     main.cpp \
     _testhelpers.cpp \
+    analysisstatstest.cpp \
     audiodatatest.cpp \
+    audioviewtest.cpp \
     binodetest.cpp \
     chromagramtest.cpp \
     chromatransformtest.cpp \
@@ -47,13 +50,17 @@ SOURCES += \
     fftadaptertest.cpp \
     keyclassifiertest.cpp \
     keyfindertest.cpp \
+    keysegmentationtest.cpp \
     lowpassfiltertest.cpp \
     lowpassfilterfactorytest.cpp \
+    resamplertest.cpp \
+    resamplerfactorytest.cpp \
     spectrumanalysertest.cpp \
     temporalwindowfactorytest.cpp \
     toneprofilestest.cpp \
     windowfunctiontest.cpp \
-    workspacetest.cpp
+    workspacetest.cpp \
+    workstealingpooltest.cpp
 
 macx{
   QMAKE_MACOSX_DEPLOYMENT_TARGET = 10.7
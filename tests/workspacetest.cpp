@@ -36,4 +36,73 @@ TEST(WorkspaceTest, ConstructorDefaultsWork)
     ASSERT_EQ(NULL, w.chromagram);
     ASSERT_EQ(NULL, w.fftAdapter);
     ASSERT_EQ(NULL, w.lpfBuffer);
+    ASSERT_EQ(NULL, w.stats);
+}
+
+TEST(WorkspaceTest, ResetKeepsAllocations)
+{
+    KeyFinder::AudioData a;
+    a.setChannels(1);
+    a.setFrameRate(44100);
+    a.addToSampleCount(44100 * 2);
+    for (unsigned int i = 0; i < a.getSampleCount(); i++) {
+        a.setSample(i, sine_wave(i, 440, 44100, 1));
+    }
+
+    KeyFinder::Workspace w;
+    KeyFinder::KeyFinder kf;
+    kf.progressiveChromagram(a, w);
+    kf.finalChromagram(w);
+    KeyFinder::Chromagram* chromagram = w.chromagram;
+    KeyFinder::FftAdapter* fftAdapter = w.fftAdapter;
+    std::vector<float>* lpfBuffer = w.lpfBuffer;
+    std::vector<float> firstChroma = chromagram->collapseToOneHop();
+    ASSERT_GT(chromagram->getHops(), 0);
+
+    w.reset();
+    ASSERT_EQ(0, w.preprocessedBuffer.getSampleCount());
+    ASSERT_EQ(0, w.preprocessedBuffer.getFrameRate());
+    ASSERT_EQ(0, w.remainderBuffer.getSampleCount());
+    ASSERT_EQ(0, w.remainderBuffer.getChannels());
+    ASSERT_EQ(chromagram, w.chromagram);
+    ASSERT_EQ(0, w.chromagram->getHops());
+    ASSERT_EQ(fftAdapter, w.fftAdapter);
+    ASSERT_EQ(lpfBuffer, w.lpfBuffer);
+
+    // a reset workspace analyses the next track as a fresh one would
+    kf.progressiveChromagram(a, w);
+    kf.finalChromagram(w);
+    std::vector<float> secondChroma = w.chromagram->collapseToOneHop();
+    for (unsigned int b = 0; b < BANDS; b++) {
+        ASSERT_FLOAT_EQ(firstChroma[b], secondChroma[b]);
+    }
+}
+
+TEST(WorkspaceTest, PoolReusesWorkspaces)
+{
+    KeyFinder::WorkspacePool pool;
+    ASSERT_EQ(0, pool.getIdleCount());
+
+    KeyFinder::Workspace* w1 = pool.acquire();
+    KeyFinder::Workspace* w2 = pool.acquire();
+    ASSERT_NE(w1, w2);
+    KeyFinder::AnalysisStats stats;
+    w1->stats = &stats;
+    w1->remainderBuffer.setChannels(1);
+    w1->remainderBuffer.addToSampleCount(10);
+    w1->retainRecentHops(0);
+    w2->retainRecentHops(0);
+
+    pool.release(w1);
+    pool.release(w2);
+    ASSERT_EQ(2, pool.getIdleCount());
+
+    KeyFinder::Workspace* w3 = pool.acquire();
+    ASSERT_TRUE((w3 == w1 || w3 == w2));
+    ASSERT_EQ(0, w3->remainderBuffer.getSampleCount());
+    ASSERT_EQ(NULL, w3->stats);
+    w3->chromagram->append(KeyFinder::Chromagram(1));
+    ASSERT_EQ(0, w3->chromagram->getFirstRetainedHop());
+    ASSERT_EQ(1, pool.getIdleCount());
+    pool.release(w3);
 }
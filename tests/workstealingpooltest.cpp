@@ -0,0 +1,60 @@
+/*************************************************************************
+
+  Copyright 2011-2015 Ibrahim Sha'ath
+
+  This file is part of LibKeyFinder.
+
+  LibKeyFinder is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  LibKeyFinder is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with LibKeyFinder.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+
+#include "_testhelpers.h"
+#include "workstealingpool.h"
+
+#include <atomic>
+
+TEST(WorkStealingPoolTest, RunsEveryTaskOnce)
+{
+    std::vector<unsigned long long> costs = { 5, 100, 1, 1, 50, 3, 3, 8, 0, 20 };
+    for (unsigned int threads : { 1U, 2U, 4U, 32U }) {
+        std::vector<std::atomic<int>> runs(costs.size());
+        KeyFinder::WorkStealingPool::run(costs, threads, [&runs](unsigned int task) { runs[task]++; });
+        for (auto& run : runs) {
+            ASSERT_EQ(1, run.load());
+        }
+    }
+}
+
+TEST(WorkStealingPoolTest, SingleThreadRunsLongestFirst)
+{
+    std::vector<unsigned long long> costs = { 5, 100, 1, 50 };
+    std::vector<unsigned int> order;
+    KeyFinder::WorkStealingPool::run(costs, 1, [&order](unsigned int task) { order.push_back(task); });
+    std::vector<unsigned int> expected = { 1, 3, 0, 2 };
+    ASSERT_EQ(expected, order);
+}
+
+TEST(WorkStealingPoolTest, RethrowsAfterRunningEverything)
+{
+    std::vector<unsigned long long> costs(10, 1);
+    std::atomic<int> runs(0);
+    ASSERT_THROW(KeyFinder::WorkStealingPool::run(costs, 3, [&runs](unsigned int task) {
+        runs++;
+        if (task == 4) {
+            throw KeyFinder::Exception("task failed");
+        }
+    }),
+        KeyFinder::Exception);
+    ASSERT_EQ(10, runs.load());
+}